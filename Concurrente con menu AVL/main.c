@@ -1,12 +1,21 @@
+#define _WIN32_WINNT 0x0602     // Windows 8 o posterior: SRWLOCK, CONDITION_VARIABLE, WSAPoll y WaitOnAddress
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <winsock2.h>   // Sockets del modo servidor - debe incluirse antes que windows.h
 #include <windows.h>    // Para crear y gestionar hilos y mutex en Windows - permite precision en obtener milisegundos
+#include "../Libreria AVL/avl.h"  // Nucleo del AVL compartido con la version secuencial
+#include "../Libreria AVL/bplus.h"    // Motor B+ alternativo con la misma interfaz
+#include "../Libreria AVL/skiplist.h" // Motor skip list sin bloqueos
 
 // Mutex Son mecanismos de sincronizacin que controlan el acceso a recursos compartidos
 // Garantizan que solo un hilo pueda acceder a un recurso compartido en un momento dado
 // Se usa para evitar conflictos y asegurar integracion de datos en la programacion multihilo
 
 #include <time.h>       // Para inicializar el generador de numeros aleatorios
+#include <malloc.h>     // _aligned_malloc para alinear los bloques del filtro de Bloom a lineas de cache
 
 
 double medirTiempo(void (*func)(void*), void* args) {
@@ -22,352 +31,3234 @@ double medirTiempo(void (*func)(void*), void* args) {
 }
 
 
-// ---------- Definicin del nodo AVL ----------
+// Estructura para almacenar los tiempos de operaciones
+struct TiemposAVL {
+    double tiempoInsercion;
+    double tiempoMostrar;
+    double tiempoBusqueda;
+    double tiempoEliminacion;
+} tiempos = {0, 0, 0, 0};
+
+
+// ---------------------------------- AVL Global ----------------------------------
+
+// Arbol global: raiz y bloqueo segun la politica de sincronizacion elegida al compilar
+// (AVL_SINCRONIZACION, ver Libreria AVL/avl.h)
+struct ArbolAVL arbol;
+
+// Motores alternativos: segun config.motor las operaciones del menu, el pool y el servidor van a uno de ellos
+struct ArbolBMas arbolBMas;
+struct ListaSkl listaSkl;
+
+// ---------------------------------- Balanceo relajado ----------------------------------
+// En modo relajado los escritores solo enlazan la hoja (sin rotar ni actualizar alturas) y
+// encolan la clave insertada. El hilo de mantenimiento (o un escritor que ayuda cuando la cola
+// se llena) recorre luego el camino de esa clave corrigiendo alturas y rotando, de a pocos
+// pasos por cada toma del mutex. Mientras haya pendientes la altura puede superar la cota AVL.
+
+#define CAPACIDAD_PENDIENTES 4096   // Claves insertadas que aun no se rebalancearon
+#define UMBRAL_AYUDA 3072           // A partir de aca los escritores ayudan al mantenimiento
+#define PASOS_POR_BLOQUEO 8         // Caminos que corrige el mantenimiento por cada toma del mutex
+#define ALTURA_MAX_CAMINO 128       // Profundidad maxima que se recorre al corregir un camino
+#define UMBRAL_COMPACTACION 1024    // Umbral inicial de borrados logicos (se cambia desde la opcion 8)
+#define LOTE_COMPACTACION 64        // Nodos que el mantenimiento desengancha por cada toma del bloqueo
+#define LOTE_LIBERACION 4096        // Nodos de rangos extraidos que el mantenimiento libera por vuelta
+
+// Estructura que atiende las operaciones
+enum MotorArbol {
+    MOTOR_AVL,
+    MOTOR_BMAS,
+    MOTOR_SKIPLIST
+};
+const char* nombresMotor[] = {"AVL", "B+", "skip list sin bloqueos"};
+const int memoriaMotor[] = {MEMORIA_AVL, MEMORIA_BMAS, MEMORIA_SKIPLIST};  // Categoria de contabilidad de sus nodos
+
+// Configuracion de los modos del arbol (se cambia desde la opcion 8 del menu)
+struct ConfigAVL {
+    int balanceoRelajado;       // 0: rotaciones dentro de la insercion - 1: rotaciones en segundo plano
+    int versionesPersistentes;  // 1: insert/delete copian el camino y publican una nueva version
+    int filtroBloom;            // 1: las busquedas consultan primero el filtro de Bloom
+    int motor;                  // MotorArbol activo (los modos anteriores son solo del AVL)
+    int borradoLogico;          // 1: eliminar solo marca el nodo y el mantenimiento lo desengancha despues
+    int umbralCompactacion;     // Borrados logicos encolados que despiertan al mantenimiento
+    int insercionConDedo;       // 1: insertar parte del ultimo lugar insertado (dedoArbol) y no de la raiz
+} config = {0, 0, 0, MOTOR_AVL, 0, UMBRAL_COMPACTACION, 0};
+
+// Dedo de las inserciones del arbol global. Se usa y se reinicia solo con el arbol tomado en escritura;
+// todo lo que cambia la forma del arbol sin pasar por el dedo lo reinicia
+struct DedoAVL dedoArbol;
+
+// Cola circular de claves pendientes de rebalanceo - protegida por el bloqueo de escritura del arbol
+struct ColaRebalanceo {
+    int claves[CAPACIDAD_PENDIENTES];
+    int inicio;
+    int cantidad;
+} pendientes = {{0}, 0, 0};
+
+HANDLE hiloMantenimiento;           // Hilo que rebalancea en segundo plano
+HANDLE eventoRebalanceo;            // Se sealiza cuando hay claves encoladas (para rebalancear o compactar)
+volatile LONG finMantenimiento = 0; // Pide al hilo de mantenimiento que termine
+struct PapeleraAVL papelera;        // Rangos extraidos del arbol global: los libera el mantenimiento
+
+/// pre: Requiere un nodo no NULL con las alturas de sus hijos ya corregidas
+///post: Actualiza la altura del nodo y, si esta desbalanceado, rota y corrige los nodos que bajaron.
+///      A diferencia de insert no asume |balance| <= 2, ya que en modo relajado puede acumularse desbalance
+struct Node* rebalancearNodo(struct Node* nodo) {
+    nodo->height = 1 + mayor(getHeight(nodo->left), getHeight(nodo->right));
+    int balance = getBalanceFactor(nodo);
+
+    if (balance > 1) {
+        if (getBalanceFactor(nodo->left) < 0) {
+            AVL_CONTAR(rotacionesDobles, 1);
+            nodo->left = leftRotate(nodo->left);
+        } else {
+            AVL_CONTAR(rotacionesSimples, 1);
+        }
+        nodo = rightRotate(nodo);
+    } else if (balance < -1) {
+        if (getBalanceFactor(nodo->right) > 0) {
+            AVL_CONTAR(rotacionesDobles, 1);
+            nodo->right = rightRotate(nodo->right);
+        } else {
+            AVL_CONTAR(rotacionesSimples, 1);
+        }
+        nodo = leftRotate(nodo);
+    } else {
+        return nodo;
+    }
+
+    // Los hijos que bajaron pueden haber quedado desbalanceados si el desbalance era mayor a 2
+    nodo->left = rebalancearNodo(nodo->left);
+    nodo->right = rebalancearNodo(nodo->right);
+    nodo->height = 1 + mayor(getHeight(nodo->left), getHeight(nodo->right));
+    return nodo;
+}
+
+/// pre: Debe tenerse el arbol en escritura - key: clave insertada en modo relajado
+///post: Recorre el camino desde la raiz hasta key y lo corrige de abajo hacia arriba.
+///      Se detiene en cuanto un ancestro no cambia de altura ni rota (el resto ya es consistente)
+void rebalancearCamino(int key) {
+    struct Node** camino[ALTURA_MAX_CAMINO];
+    struct Node** enlace = &arbol.raiz;
+    int n = 0;
+
+    while (*enlace != NULL && n < ALTURA_MAX_CAMINO) {
+        camino[n++] = enlace;
+        if (key == (*enlace)->key)
+            break;
+        enlace = (key < (*enlace)->key) ? &(*enlace)->left : &(*enlace)->right;
+    }
+
+    AVL_CONTAR_REBALANCEO();    // En modo relajado la propagacion se cuenta al corregir el camino
+    for (int i = n - 1; i >= 0; i--) {
+        struct Node* nodo = *camino[i];
+        int alturaPrevia = nodo->height;
+        *camino[i] = rebalancearNodo(nodo);
+
+        if (nodo->key != key && *camino[i] == nodo && nodo->height == alturaPrevia)
+            break;
+        AVL_CONTAR_NIVEL_SI(nodo->key != key);
+    }
+}
+
+/// pre: Debe tenerse el arbol en escritura - key: clave a insertar
+///post: Inserta key como hoja sin rotar ni actualizar alturas y la encola para el mantenimiento.
+///      Si la cola esta llena rebalancea el camino en el momento. Retorna 1 si se inserto, 0 si ya existia
+int insertRelajado(int key) {
+    struct Node** enlace = &arbol.raiz;
+
+    while (*enlace != NULL) {
+        if (key < (*enlace)->key)
+            enlace = &(*enlace)->left;
+        else if (key > (*enlace)->key)
+            enlace = &(*enlace)->right;
+        else
+            return revivirNodo(*enlace); // No se permiten duplicados, salvo que estuviera borrado logicamente
+    }
+    *enlace = createNode(key);
+
+    if (pendientes.cantidad == CAPACIDAD_PENDIENTES) {
+        rebalancearCamino(key);
+        return 1;
+    }
+
+    pendientes.claves[(pendientes.inicio + pendientes.cantidad) % CAPACIDAD_PENDIENTES] = key;
+    pendientes.cantidad++;
+    SetEvent(eventoRebalanceo);
+    return 1;
+}
+
+/// pre: Debe tenerse el arbol en escritura - pasos: cantidad maxima de caminos a corregir
+///post: Saca hasta pasos claves de la cola y rebalancea su camino. Retorna las claves que siguen pendientes
+int procesarPendientes(int pasos) {
+    if (pendientes.cantidad > 0)
+        dedoReiniciar(&dedoArbol);      // Las rotaciones pueden mover el camino del dedo
+    while (pasos-- > 0 && pendientes.cantidad > 0) {
+        int key = pendientes.claves[pendientes.inicio];
+        pendientes.inicio = (pendientes.inicio + 1) % CAPACIDAD_PENDIENTES;
+        pendientes.cantidad--;
+        rebalancearCamino(key);
+    }
+    return pendientes.cantidad;
+}
+
+/// pre:
+///post: Bloquea hasta que no queden claves pendientes de rebalanceo (el arbol vuelve a ser AVL estricto)
+void drenarRebalanceo() {
+    avlBloquearEscritura(&arbol);
+    procesarPendientes(CAPACIDAD_PENDIENTES);
+    avlLiberarEscritura(&arbol);
+}
+
+
+// ---------------------------------- Versiones persistentes ----------------------------------
+// En modo persistente el arbol publicado nunca se modifica: insert/delete copian solo los O(log n)
+// nodos del camino (el resto se comparte) y publican una raiz nueva. Un lector fija la version
+// vigente y la recorre sin mutex el tiempo que necesite. Cada nodo cuenta cuantos padres lo
+// comparten y cada version cuantos lectores la tienen fijada; al llegar a 0 se liberan.
+
+// Version publicada del arbol
+struct VersionAVL {
+    struct Node* raiz;
+    volatile LONG refs;     // Lectores que la tienen fijada + 1 mientras sea la version vigente
+};
+
+struct VersionAVL* versionActual = NULL;
+SRWLOCK lockVersion = SRWLOCK_INIT;     // Solo protege fijar/reemplazar el puntero versionActual
+
+/// pre: n puede ser NULL
+///post: Suma un padre al nodo y lo retorna (para compartir el subarbol en la nueva version)
+struct Node* retenerNodo(struct Node* n) {
+    if (n != NULL)
+        InterlockedIncrement(&n->refs);
+    return n;
+}
+
+/// pre: n puede ser NULL
+///post: Resta un padre al nodo; si nadie mas lo comparte lo libera junto con los hijos que queden sin padres
+void soltarNodo(struct Node* n) {
+    while (n != NULL && InterlockedDecrement(&n->refs) == 0) {
+        struct Node* der = n->right;
+        soltarNodo(n->left);
+        liberarNodo(n);
+        AVL_CONTAR(liberaciones, 1);
+        n = der;
+    }
+}
+
+/// pre: left y right son referencias propias que pasan a ser del nodo nuevo
+///post: Crea un nodo inmutable con la altura calculada y refs = 1 (propiedad del llamador)
+struct Node* crearNodoPersistente(struct Node* left, int key, struct Node* right) {
+    struct Node* node = createNode(key);
+    node->left = left;
+    node->right = right;
+    node->height = 1 + mayor(getHeight(left), getHeight(right));
+    return node;
+}
+
+/// pre: left y right son referencias propias, cuyas alturas difieren a lo sumo en 2
+///post: Arma el nodo (left, key, right) rotando con nodos nuevos si queda desbalanceado.
+///      Los nodos que se desarman se sueltan, asi los intermedios de esta misma operacion se liberan
+struct Node* balancearPersistente(struct Node* left, int key, struct Node* right) {
+    if (getHeight(left) > getHeight(right) + 1) {
+        struct Node* ll = retenerNodo(left->left);
+        struct Node* lr = retenerNodo(left->right);
+        int lk = left->key;
+        soltarNodo(left);
+
+        if (getHeight(ll) >= getHeight(lr)) {   // Rotacion simple a la derecha
+            AVL_CONTAR(rotacionesSimples, 1);
+            return crearNodoPersistente(ll, lk, crearNodoPersistente(lr, key, right));
+        }
+
+        struct Node* lrl = retenerNodo(lr->left);   // Rotacion izquierda-derecha
+        struct Node* lrr = retenerNodo(lr->right);
+        int lrk = lr->key;
+        soltarNodo(lr);
+        AVL_CONTAR(rotacionesDobles, 1);
+        return crearNodoPersistente(crearNodoPersistente(ll, lk, lrl), lrk, crearNodoPersistente(lrr, key, right));
+    }
+
+    if (getHeight(right) > getHeight(left) + 1) {
+        struct Node* rl = retenerNodo(right->left);
+        struct Node* rr = retenerNodo(right->right);
+        int rk = right->key;
+        soltarNodo(right);
+
+        if (getHeight(rr) >= getHeight(rl)) {   // Rotacion simple a la izquierda
+            AVL_CONTAR(rotacionesSimples, 1);
+            return crearNodoPersistente(crearNodoPersistente(left, key, rl), rk, rr);
+        }
+
+        struct Node* rll = retenerNodo(rl->left);   // Rotacion derecha-izquierda
+        struct Node* rlr = retenerNodo(rl->right);
+        int rlk = rl->key;
+        soltarNodo(rl);
+        AVL_CONTAR(rotacionesDobles, 1);
+        return crearNodoPersistente(crearNodoPersistente(left, key, rll), rlk, crearNodoPersistente(rlr, rk, rr));
+    }
+
+    return crearNodoPersistente(left, key, right);
+}
+
+/// pre: node pertenece a una version publicada (no se modifica) - key: dato a insertar
+///post: Retorna la raiz propia de un arbol nuevo con key, copiando solo el camino hasta la hoja
+struct Node* insertPersistente(struct Node* node, int key) {
+    if (node == NULL)
+        return createNode(key);
+    if (key < node->key)
+        return balancearPersistente(insertPersistente(node->left, key), node->key, retenerNodo(node->right));
+    if (key > node->key)
+        return balancearPersistente(retenerNodo(node->left), node->key, insertPersistente(node->right, key));
+    return retenerNodo(node);   // Ya existe: se comparte el subarbol entero
+}
+
+/// pre: node pertenece a una version publicada (no se modifica) - key: dato a eliminar
+///post: Retorna la raiz propia de un arbol nuevo sin key, copiando solo el camino afectado
+struct Node* deletePersistente(struct Node* node, int key) {
+    if (node == NULL)
+        return NULL;
+    if (key < node->key)
+        return balancearPersistente(deletePersistente(node->left, key), node->key, retenerNodo(node->right));
+    if (key > node->key)
+        return balancearPersistente(retenerNodo(node->left), node->key, deletePersistente(node->right, key));
+
+    if (node->left == NULL)
+        return retenerNodo(node->right);
+    if (node->right == NULL)
+        return retenerNodo(node->left);
+
+    // Nodo con dos hijos: se reemplaza por el sucesor en inorden
+    int sucesor = minValueNode(node->right)->key;
+    return balancearPersistente(retenerNodo(node->left), sucesor, deletePersistente(node->right, sucesor));
+}
+
+/// pre: Ya se publico al menos una version
+///post: Fija la version vigente para recorrerla sin mutex; debe devolverse con soltarVersion
+struct VersionAVL* fijarVersion() {
+    AcquireSRWLockShared(&lockVersion);
+    struct VersionAVL* version = versionActual;
+    InterlockedIncrement(&version->refs);
+    ReleaseSRWLockShared(&lockVersion);
+    return version;
+}
+
+/// pre: version fue obtenida con fijarVersion o publicarVersion
+///post: La suelta; si era la ultima referencia libera los nodos que solo ella usaba
+void soltarVersion(struct VersionAVL* version) {
+    if (InterlockedDecrement(&version->refs) == 0) {
+        soltarNodo(version->raiz);
+        free(version);
+    }
+}
+
+/// pre: raiz es una referencia propia (puede ser NULL) - Deben serializarse los escritores (avlBloquearEscritura)
+///post: Publica raiz como version vigente y suelta la anterior, que se libera cuando ningun lector la use
+void publicarVersion(struct Node* raiz) {
+    struct VersionAVL* nueva = (struct VersionAVL*)malloc(sizeof(struct VersionAVL));
+    nueva->raiz = raiz;
+    nueva->refs = 1;
+
+    AcquireSRWLockExclusive(&lockVersion);
+    struct VersionAVL* anterior = versionActual;
+    versionActual = nueva;
+    ReleaseSRWLockExclusive(&lockVersion);
+
+    if (anterior != NULL)
+        soltarVersion(anterior);
+}
+
+/// pre: nodo es un arbol publicado
+///post: Retorna una copia independiente (refs = 1 en cada nodo) que puede modificarse con insert/deleteNode
+struct Node* copiarArbol(struct Node* nodo) {
+    if (nodo == NULL)
+        return NULL;
+    struct Node* copia = createNode(nodo->key);
+    copia->left = copiarArbol(nodo->left);
+    copia->right = copiarArbol(nodo->right);
+    copia->height = nodo->height;
+    return copia;
+}
 
-// Estructura del Nodo arbol AVL
-// key: representa el dato.
-// posee un puntero a sus hijos, siendo otro nodo, izq y derecho
-// height: representa la altura, y permite calcular el balance del arbol
-/// Estructura NODO - key: es el dato siendo un entero - poseen punteros a sus hijos left y rigth, siendo nodos del lado izq y der
+/// pre: Solo desde el hilo del menu
+///post: En modo persistente fija la version vigente (sin bloquear a los escritores) y la retorna;
+///      en modo normal bloquea el arbol para lectura y retorna NULL. La raiz a recorrer es version ? version->raiz : arbol.raiz
+struct VersionAVL* abrirLectura() {
+    if (config.versionesPersistentes)
+        return fijarVersion();
+    avlBloquearLectura(&arbol);
+    return NULL;
+}
+
+/// pre: version es lo que retorno abrirLectura
+///post: Suelta la version fijada o libera el bloqueo de lectura
+void cerrarLectura(struct VersionAVL* version) {
+    if (version != NULL)
+        soltarVersion(version);
+    else
+        avlLiberarLectura(&arbol);
+}
+
+
+// ---------------------------------- Traza de operaciones ----------------------------------
+// Mientras se graba, cada insercion, busqueda y eliminacion que entra por insertarClave, buscarConFiltro,
+// eliminarClave o la opcion 3 anota un registro de 12 bytes (operacion, clave, hilo y microsegundos
+// desde el inicio) en un buffer reservado de antemano. Escribir el archivo queda para cuando se
+// detiene la grabacion, asi grabar cuesta una suma atomica y una lectura del reloj por operacion.
+// Sin grabar, el costo es leer captura.activa.
+
+#define VERSION_TRAZA 1
+
+enum OperacionTraza {
+    TRAZA_INSERTAR,
+    TRAZA_BUSCAR,
+    TRAZA_ELIMINAR
+};
+const char* nombresOperacionTraza[] = {"inserciones", "busquedas", "eliminaciones"};
 
-struct Node {
+// Registro del archivo: 12 bytes sin relleno
+struct RegistroTraza {
+    unsigned int microsegundos;     // Desde el inicio de la grabacion (alcanza para 71 minutos: lo que
+                                    // pase despues no se graba y cuenta como perdido)
     int key;
-    struct Node* left;
-    struct Node* right;
-    int height;
+    unsigned short hilo;            // Numero del hilo en orden de aparicion dentro de la grabacion
+    unsigned char operacion;        // OperacionTraza
+    unsigned char reservado;
+};
+
+// Cabecera del archivo: le siguen las claves que tenia el motor al empezar y despues los registros
+struct CabeceraTraza {
+    char magia[4];                  // "AVLT"
+    int version;                    // VERSION_TRAZA
+    int claves;                     // Claves iniciales, ordenadas
+    int registros;
+    int hilos;                      // Hilos distintos que aparecen en los registros
+    int perdidos;                   // Operaciones que no entraron en el buffer o pasaron los 71 minutos
+};
+
+struct CapturaTraza {
+    volatile LONG activa;
+    SRWLOCK lock;                   // Compartido: anotar - Exclusivo: empezar o detener
+    struct RegistroTraza* registros;
+    volatile LONG cantidad;         // Lugares pedidos: puede pasar de capacidad (los demas se pierden)
+    LONG capacidad;
+    volatile LONG vencidas;         // Operaciones despues de UINT_MAX microsegundos: no se anotan
+    volatile LONG hilos;
+    LONG generacion;                // Cambia en cada grabacion: invalida los numeros de hilo anteriores
+    DWORD tlsHilo;                  // Por hilo: generacion << 16 | (numero + 1)
+    LARGE_INTEGER inicio;
+    LARGE_INTEGER frecuencia;
+    int* claves;                    // Foto del motor al empezar
+    int cantidadClaves;
+    char ruta[MAX_PATH];
+} captura = {0, SRWLOCK_INIT};
+
+/// pre: captura.activa (se vuelve a mirar con el lock tomado)
+///post: Anota la operacion con el numero de este hilo y el tiempo desde el inicio de la grabacion.
+///      Pasados UINT_MAX microsegundos ya no anota: cuenta la operacion en captura.vencidas
+void trazaAnotarGrabando(int operacion, int key) {
+    LARGE_INTEGER ahora;
+
+    AcquireSRWLockShared(&captura.lock);
+    if (captura.activa && captura.vencidas > 0) {
+        InterlockedIncrement(&captura.vencidas);    // El reloj solo avanza: no hace falta volver a leerlo
+    } else if (captura.activa) {
+        QueryPerformanceCounter(&ahora);
+        LONGLONG microsegundos = (ahora.QuadPart - captura.inicio.QuadPart) * 1000000 / captura.frecuencia.QuadPart;
+        if (microsegundos > UINT_MAX) {
+            InterlockedIncrement(&captura.vencidas);
+        } else {
+            LONG i = InterlockedIncrement(&captura.cantidad) - 1;
+            if (i < captura.capacidad) {
+                LONG_PTR marca = (LONG_PTR)TlsGetValue(captura.tlsHilo);
+                if ((marca >> 16) != captura.generacion) {
+                    marca = ((LONG_PTR)captura.generacion << 16) | InterlockedIncrement(&captura.hilos);
+                    TlsSetValue(captura.tlsHilo, (LPVOID)marca);
+                }
+                captura.registros[i].microsegundos = (unsigned int)microsegundos;
+                captura.registros[i].key = key;
+                captura.registros[i].hilo = (unsigned short)((marca & 0xFFFF) - 1);
+                captura.registros[i].operacion = (unsigned char)operacion;
+                captura.registros[i].reservado = 0;
+            }
+        }
+    }
+    ReleaseSRWLockShared(&captura.lock);
+}
+
+/// pre: operacion es una OperacionTraza
+///post: Si se esta grabando, anota la operacion en la traza
+static inline void trazaAnotar(int operacion, int key) {
+    if (captura.activa)
+        trazaAnotarGrabando(operacion, key);
+}
+
+
+// ---------------------------------- Filtro de Bloom por bloques ----------------------------------
+// Cada clave cae en un solo bloque de 512 bits (una linea de cache) y marca HASHES_BLOOM bits dentro
+// de el, asi una consulta lee una sola linea. Si algun bit esta en 0 la clave seguro no esta y la
+// busqueda termina sin bloquear ni recorrer el arbol. Los borrados no apagan bits (otras
+// claves pueden compartirlos): se cuentan y el filtro se reconstruye cuando superan un umbral.
+
+#define BITS_POR_CLAVE 10           // ~1% de falsos positivos con 7 hashes
+#define HASHES_BLOOM 7
+#define PALABRAS_POR_BLOQUE 8       // 8 palabras de 64 bits = 512 bits = 64 bytes
+#define CAPACIDAD_MINIMA_FILTRO 1024
+#define PORCENTAJE_RECONSTRUCCION 25 // Se reconstruye si los borrados superan este % de las claves
+
+struct FiltroBloom {
+    volatile unsigned long long* bloques;   // cantidadBloques * PALABRAS_POR_BLOQUE palabras
+    unsigned int mascaraBloques;            // cantidadBloques - 1 (cantidadBloques es potencia de 2)
+    int claves;                             // Claves agregadas desde la ultima reconstruccion
+    int capacidad;                          // Claves para las que se dimensiono
+    int eliminaciones;                      // Borrados cuyos bits siguen encendidos
+} filtro = {NULL, 0, 0, 0, 0};
+
+// Compartido para consultar/agregar, exclusivo para reemplazar el arreglo de bloques
+SRWLOCK lockFiltro = SRWLOCK_INIT;
+
+/// pre: key es un entero cualquiera
+///post: Mezcla los bits de key (finalizador de MurmurHash3) para repartir bien claves consecutivas
+unsigned long long hashClave(int key) {
+    unsigned long long h = (unsigned int)key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/// pre: f->bloques != NULL - para el filtro global debe tenerse lockFiltro (compartido alcanza si ademas
+///      se tiene el arbol en escritura)
+///post: Enciende los bits de key en su bloque
+void filtroMarcar(struct FiltroBloom* f, int key) {
+    unsigned long long h = hashClave(key);
+    volatile unsigned long long* bloque = f->bloques + (size_t)(h & f->mascaraBloques) * PALABRAS_POR_BLOQUE;
+    unsigned int h1 = (unsigned int)(h >> 32);
+    unsigned int h2 = (unsigned int)(h >> 23) | 1;
+
+    for (int i = 0; i < HASHES_BLOOM; i++) {
+        unsigned int bit = (h1 + i * h2) & (PALABRAS_POR_BLOQUE * 64 - 1);
+        bloque[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+/// pre: Para el filtro global debe tenerse lockFiltro en modo compartido
+///post: Retorna 0 si key seguro no fue agregada, 1 si puede estar (o si el filtro no existe)
+int filtroConsultar(struct FiltroBloom* f, int key) {
+    if (f->bloques == NULL)
+        return 1;
+
+    unsigned long long h = hashClave(key);
+    volatile unsigned long long* bloque = f->bloques + (size_t)(h & f->mascaraBloques) * PALABRAS_POR_BLOQUE;
+    unsigned int h1 = (unsigned int)(h >> 32);
+    unsigned int h2 = (unsigned int)(h >> 23) | 1;
+
+    for (int i = 0; i < HASHES_BLOOM; i++) {
+        unsigned int bit = (h1 + i * h2) & (PALABRAS_POR_BLOQUE * 64 - 1);
+        if ((bloque[bit / 64] & (1ULL << (bit % 64))) == 0)
+            return 0;
+    }
+    return 1;
+}
+
+/// pre: f->bloques != NULL
+///post: Marca en f todas las claves del subarbol
+void filtroCargarArbol(struct FiltroBloom* f, struct Node* nodo) {
+    if (nodo == NULL)
+        return;
+    filtroMarcar(f, nodo->key);
+    filtroCargarArbol(f, nodo->left);
+    filtroCargarArbol(f, nodo->right);
+}
+
+/// pre: capacidad > 0
+///post: Cantidad de bloques (potencia de 2) para capacidad claves a BITS_POR_CLAVE bits cada una
+unsigned int filtroCantidadBloques(int capacidad) {
+    unsigned int cantidadBloques = 1;
+    while ((unsigned long long)cantidadBloques * PALABRAS_POR_BLOQUE * 64 < (unsigned long long)capacidad * BITS_POR_CLAVE)
+        cantidadBloques <<= 1;
+    return cantidadBloques;
+}
+
+/// pre: Debe tenerse el arbol en escritura - capacidad: claves esperadas
+///post: Descarta el filtro actual y arma uno nuevo, dimensionado para capacidad, con las claves del arbol activo
+void filtroReconstruir(int capacidad) {
+    struct Node* raiz = config.versionesPersistentes ? versionActual->raiz : arbol.raiz;
+    int nodos = contarNodos(raiz);
+    if (capacidad < nodos)
+        capacidad = nodos;
+    if (capacidad < CAPACIDAD_MINIMA_FILTRO)
+        capacidad = CAPACIDAD_MINIMA_FILTRO;
+
+    unsigned int cantidadBloques = filtroCantidadBloques(capacidad);
+    size_t bytes = (size_t)cantidadBloques * PALABRAS_POR_BLOQUE * sizeof(unsigned long long);
+    unsigned long long* nuevos = (unsigned long long*)_aligned_malloc(bytes, 64);
+    if (nuevos == NULL) {
+        printf("No hay memoria para el filtro de Bloom, se desactiva.\n");
+        config.filtroBloom = 0;
+    } else {
+        memset(nuevos, 0, bytes);
+    }
+
+    AcquireSRWLockExclusive(&lockFiltro);
+    if (filtro.bloques != NULL)
+        _aligned_free((void*)filtro.bloques);
+    filtro.bloques = nuevos;
+    filtro.mascaraBloques = cantidadBloques - 1;
+    filtro.claves = nodos;
+    filtro.capacidad = capacidad;
+    filtro.eliminaciones = 0;
+    if (nuevos != NULL)
+        filtroCargarArbol(&filtro, raiz);
+    ReleaseSRWLockExclusive(&lockFiltro);
+}
+
+/// pre: Debe tenerse el arbol en escritura
+///post: Libera el filtro (queda sin filtro: toda consulta responde "puede estar")
+void filtroDescartar() {
+    AcquireSRWLockExclusive(&lockFiltro);
+    if (filtro.bloques != NULL)
+        _aligned_free((void*)filtro.bloques);
+    filtro.bloques = NULL;
+    filtro.claves = filtro.capacidad = filtro.eliminaciones = 0;
+    ReleaseSRWLockExclusive(&lockFiltro);
+}
+
+/// pre: Debe tenerse el arbol en escritura - key acaba de insertarse en el arbol
+///post: Agrega key al filtro; si se supero la capacidad lo reconstruye con el doble de tamao
+void filtroAgregar(int key) {
+    if (!config.filtroBloom)
+        return;
+    if (filtro.claves >= filtro.capacidad) {
+        filtroReconstruir(filtro.capacidad * 2);   // El arbol ya contiene key
+        return;
+    }
+    AcquireSRWLockShared(&lockFiltro);
+    filtroMarcar(&filtro, key);
+    filtro.claves++;
+    ReleaseSRWLockShared(&lockFiltro);
+}
+
+/// pre: Debe tenerse el arbol en escritura - se eliminaron cantidad claves del arbol
+///post: Cuenta los borrados y reconstruye el filtro si los bits sobrantes ya suben mucho los falsos positivos
+void filtroEliminarVarias(long long cantidad) {
+    if (!config.filtroBloom)
+        return;
+    filtro.eliminaciones += (int)cantidad;
+    if (filtro.eliminaciones * 100 > filtro.claves * PORCENTAJE_RECONSTRUCCION)
+        filtroReconstruir(filtro.capacidad);
+}
+
+/// pre: Debe tenerse el arbol en escritura - se acaba de eliminar una clave del arbol
+///post: Cuenta el borrado (ver filtroEliminarVarias)
+void filtroEliminar() {
+    filtroEliminarVarias(1);
+}
+
+/// pre: key: dato a buscar
+///post: Consulta el filtro sin bloquear el arbol; solo si la clave puede estar busca en el arbol activo.
+///      Retorna 1 si esta, 0 si no
+int buscarConFiltro(int key) {
+    trazaAnotar(TRAZA_BUSCAR, key);
+    if (config.motor == MOTOR_BMAS)
+        return bmasContiene(&arbolBMas, key);
+    if (config.motor == MOTOR_SKIPLIST)
+        return sklContiene(&listaSkl, key);
+    if (config.filtroBloom) {
+        AcquireSRWLockShared(&lockFiltro);
+        int puedeEstar = filtroConsultar(&filtro, key);
+        ReleaseSRWLockShared(&lockFiltro);
+        if (!puedeEstar)
+            return 0;
+    }
+
+    if (config.versionesPersistentes) {
+        struct VersionAVL* version = fijarVersion();
+        int encontrado = buscarAVL(version->raiz, key);
+        soltarVersion(version);
+        return encontrado;
+    }
+    return avlContiene(&arbol, key);   // Con la politica fina baja nodo por nodo
+}
+
+/// pre: destino tiene lugar para todas las claves del subarbol - i: primera posicion libre
+///post: Copia las claves del subarbol en orden ascendente, sin las borradas logicamente, y retorna la
+///      siguiente posicion libre
+int recolectarClaves(struct Node* nodo, int* destino, int i) {
+    if (nodo == NULL)
+        return i;
+    i = recolectarClaves(nodo->left, destino, i);
+    if (!nodoBorrado(nodo))
+        destino[i++] = nodo->key;
+    return recolectarClaves(nodo->right, destino, i);
+}
+
+/// pre: El arbol activo no esta vacio - consultas: busquedas por medicion
+///post: Copia las claves del arbol activo en un arbol y un filtro de Bloom propios y mide busquedas por
+///      segundo sin y con el filtro, para distintas proporciones de fallos, e imprime la tabla. No toca
+///      config ni el filtro compartido: el servidor, el pool y el mantenimiento siguen marcando sus inserciones
+void benchmarkFiltroBloom(int consultas) {
+    static const int porcentajesFallo[] = {0, 25, 50, 75, 90, 99};
+    int cantidadPorcentajes = sizeof(porcentajesFallo) / sizeof(porcentajesFallo[0]);
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+
+    avlBloquearEscritura(&arbol);
+    struct Node* raiz = config.versionesPersistentes ? versionActual->raiz : arbol.raiz;
+    int nodos = contarNodos(raiz);
+    int* presentes = (int*)malloc(nodos * sizeof(int));
+    int vivos = recolectarClaves(raiz, presentes, 0);
+    avlLiberarEscritura(&arbol);
+
+    struct Node* copia = construirOrdenado(presentes, vivos);
+    int* ausentes = (int*)malloc(consultas * sizeof(int));
+    int* claves = (int*)malloc(consultas * sizeof(int));
+    for (int i = 0; i < consultas; i++) {
+        do {
+            ausentes[i] = (rand() << 15) ^ rand();  // rand() puede devolver solo 15 bits
+        } while (buscarAVL(copia, ausentes[i]));
+    }
+
+    struct FiltroBloom propio = {NULL, 0, vivos, vivos > CAPACIDAD_MINIMA_FILTRO ? vivos : CAPACIDAD_MINIMA_FILTRO, 0};
+    unsigned int cantidadBloques = filtroCantidadBloques(propio.capacidad);
+    size_t bytes = (size_t)cantidadBloques * PALABRAS_POR_BLOQUE * sizeof(unsigned long long);
+    propio.bloques = (unsigned long long*)_aligned_malloc(bytes, 64);
+    if (propio.bloques == NULL) {
+        printf("No hay memoria para el filtro de Bloom.\n");
+        liberarArbol(copia);
+        free(presentes);
+        free(ausentes);
+        free(claves);
+        return;
+    }
+    memset((void*)propio.bloques, 0, bytes);
+    propio.mascaraBloques = cantidadBloques - 1;
+    filtroCargarArbol(&propio, copia);
+
+    printf("\n======== BUSQUEDAS SEGUN PROPORCION DE FALLOS (%d consultas) ========\n", consultas);
+    printf("| %-10s | %-18s | %-18s |\n", "% fallos", "Sin filtro (Mops)", "Con filtro (Mops)");
+    printf("|------------|--------------------|--------------------|\n");
+
+    for (int p = 0; p < cantidadPorcentajes; p++) {
+        for (int i = 0; i < consultas; i++)
+            claves[i] = (vivos == 0 || rand() % 100 < porcentajesFallo[p]) ? ausentes[i] : presentes[rand() % vivos];
+
+        double mops[2];
+        for (int conFiltro = 0; conFiltro <= 1; conFiltro++) {
+            volatile int encontrados = 0;
+            QueryPerformanceCounter(&start);
+            for (int i = 0; i < consultas; i++)
+                encontrados += (!conFiltro || filtroConsultar(&propio, claves[i])) && buscarAVL(copia, claves[i]);
+            QueryPerformanceCounter(&end);
+            double segundos = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+            mops[conFiltro] = consultas / segundos / 1e6;
+        }
+        printf("| %-10d | %-18.3lf | %-18.3lf |\n", porcentajesFallo[p], mops[0], mops[1]);
+    }
+
+    _aligned_free((void*)propio.bloques);
+    liberarArbol(copia);
+    free(presentes);
+    free(ausentes);
+    free(claves);
+}
+
+
+// ---------------------------------- Borrado logico y compactacion ----------------------------------
+// Con borrado logico eliminar no toma el arbol en escritura: baja como una busqueda y marca el nodo
+// (avlMarcarBorrado). Busquedas y recorridos ignoran los nodos marcados, y reinsertar la clave solo
+// quita la marca. Las claves marcadas se encolan y, cuando pasan config.umbralCompactacion, el hilo
+// de mantenimiento las desengancha con deleteNode de a LOTE_COMPACTACION por toma del bloqueo,
+// asi los escritores esperan un lote y no toda la compactacion. No se combina con versiones
+// persistentes: un nodo marcado puede estar compartido con versiones viejas.
+
+// Claves marcadas pendientes de desenganchar. Los borrados encolan con el arbol compartido, por eso
+// la cola tiene su propio bloqueo. Puede tener claves que despues se reinsertaron: se saltean
+struct ColaBorrados {
+    int* claves;
+    int cantidad;
+    int capacidad;
+    SRWLOCK lock;
+    SRWLOCK compactando;    // Una compactacion a la vez: quien pide otra espera a que termine la actual
+} borrados = {NULL, 0, 0, SRWLOCK_INIT, SRWLOCK_INIT};
+
+/// pre: key se acaba de marcar con avlMarcarBorrado
+///post: La encola para el compactador y lo despierta si se llego al umbral
+void encolarBorrado(int key) {
+    AcquireSRWLockExclusive(&borrados.lock);
+    if (borrados.cantidad == borrados.capacidad) {
+        borrados.capacidad = borrados.capacidad * 2 + LOTE_COMPACTACION;
+        borrados.claves = (int*)realloc(borrados.claves, borrados.capacidad * sizeof(int));
+    }
+    borrados.claves[borrados.cantidad++] = key;
+    int despertar = borrados.cantidad >= config.umbralCompactacion;
+    ReleaseSRWLockExclusive(&borrados.lock);
+
+    if (despertar)
+        SetEvent(eventoRebalanceo);
+}
+
+/// pre: Debe tenerse el arbol tomado
+///post: Retorna el nodo con key aunque este borrado logicamente, o NULL si no esta enlazado
+struct Node* nodoConClave(struct Node* nodo, int key) {
+    while (nodo != NULL && nodo->key != key)
+        nodo = (key < nodo->key) ? nodo->left : nodo->right;
+    return nodo;
+}
+
+/// pre: No tener el arbol tomado
+///post: Vacia la cola y desengancha (con rotaciones) los nodos que siguen marcados, de a LOTE_COMPACTACION
+///      por cada toma del bloqueo de escritura. Retorna cuantos nodos quito
+int compactarBorrados() {
+    AcquireSRWLockExclusive(&borrados.compactando);
+    AcquireSRWLockExclusive(&borrados.lock);
+    int* claves = borrados.claves;
+    int cantidad = borrados.cantidad;
+    borrados.claves = NULL;
+    borrados.cantidad = borrados.capacidad = 0;
+    ReleaseSRWLockExclusive(&borrados.lock);
+
+    int quitados = 0;
+    for (int i = 0; i < cantidad; i += LOTE_COMPACTACION) {
+        avlBloquearEscritura(&arbol);
+        for (int j = i; j < cantidad && j < i + LOTE_COMPACTACION; j++) {
+            struct Node* nodo = nodoConClave(arbol.raiz, claves[j]);
+            if (nodo != NULL && nodoBorrado(nodo)) {    // Si se reinserto despues del borrado se deja
+                arbol.raiz = deleteNode(arbol.raiz, claves[j]);
+                dedoReiniciar(&dedoArbol);
+                filtroEliminar();
+                quitados++;
+            }
+        }
+        avlLiberarEscritura(&arbol);
+    }
+    ReleaseSRWLockExclusive(&borrados.compactando);
+    free(claves);
+    return quitados;
+}
+
+/// pre: No tener el arbol tomado - maximo: nodos a liberar como mucho (0: todos)
+///post: Libera rangos extraidos de la papelera sin tomar el arbol y descuenta sus claves del filtro.
+///      Retorna cuantos nodos libero
+long long vaciarPapelera(long long maximo) {
+    long long liberados = papeleraLiberar(&papelera, maximo);
+    if (liberados > 0 && config.filtroBloom) {
+        avlBloquearEscritura(&arbol);
+        filtroEliminarVarias(liberados);
+        avlLiberarEscritura(&arbol);
+    }
+    return liberados;
+}
+
+/// pre: Se lanza una sola vez desde main
+///post: Espera claves encoladas y las rebalancea de a PASOS_POR_BLOQUEO, soltando el mutex entre tandas
+///      para que los escritores no esperen a que termine todo el trabajo pendiente. Si los borrados
+///      logicos llegaron al umbral tambien los compacta, y libera los rangos extraidos de la papelera
+DWORD WINAPI threadMantenimiento(LPVOID args) {
+    while (!finMantenimiento) {
+        WaitForSingleObject(eventoRebalanceo, 100);
+
+        int quedan = 1;
+        while (quedan > 0 && !finMantenimiento) {
+            avlBloquearEscritura(&arbol);
+            quedan = procesarPendientes(PASOS_POR_BLOQUEO);
+            avlLiberarEscritura(&arbol);
+        }
+        if (borrados.cantidad >= config.umbralCompactacion && !finMantenimiento)   // Lectura sin bloqueo: solo decide si compactar
+            compactarBorrados();
+        while (papelera.pendientes != NULL && !finMantenimiento)   // Lectura sin bloqueo: solo decide si liberar
+            vaciarPapelera(LOTE_LIBERACION);
+    }
+    return 0;
+}
+
+// ---------------------------------- Validacion y estadisticas ----------------------------------
+// Verifica el orden de las claves, que la altura guardada coincida con la real y que ningun factor
+// de balance supere 1, y junta el histograma de profundidades. La parte alta del arbol se corta a
+// PROFUNDIDAD_CORTE niveles: cada subarbol de ese nivel es una tarea que toma el primer hilo libre,
+// y al final el hilo principal valida los nodos de arriba usando las alturas que midieron las tareas.
+
+#define PROFUNDIDAD_CORTE 8     // Hasta 256 tareas, suficiente para repartir entre decenas de hilos
+#define MAX_HILOS_VALIDACION 64
+
+struct EstadisticasAVL {
+    long long nodos;
+    long long erroresOrden;         // Claves fuera del rango que imponen sus ancestros
+    long long erroresAltura;        // Altura guardada distinta de la real
+    long long erroresBalance;       // |factor de balance real| > 1
+    int maxDesbalance;              // Mayor |factor de balance real| encontrado
+    long long sumaProfundidades;    // Para el largo promedio de busqueda
+    long long histograma[ALTURA_MAX_CAMINO];    // Nodos por profundidad (raiz = 0)
+    int altura;
+};
+
+// Subarbol a validar por un hilo: claves permitidas en (min, max) exclusivo
+struct TareaValidacion {
+    struct Node* nodo;
+    long long min;
+    long long max;
+    int profundidad;
+    int alturaReal;     // La completa el hilo que la procesa
+};
+
+struct TrabajoValidacion {
+    struct TareaValidacion* tareas;
+    int cantidadTareas;
+    volatile LONG siguiente;        // Proxima tarea sin tomar
+    struct EstadisticasAVL* parciales;  // Una por hilo, se suman al final
+};
+
+// Argumentos de cada hilo de validacion
+struct ArgsValidacion {
+    struct TrabajoValidacion* trabajo;
+    struct EstadisticasAVL* stats;      // Parcial propia del hilo
+};
+
+/// pre: stats inicializada en 0 - min/max: rango exclusivo permitido por los ancestros
+///post: Valida el subarbol acumulando en stats y retorna su altura real
+int validarSubarbol(struct Node* nodo, long long min, long long max, int profundidad, struct EstadisticasAVL* stats) {
+    if (nodo == NULL)
+        return 0;
+
+    stats->nodos++;
+    stats->sumaProfundidades += profundidad;
+    stats->histograma[profundidad < ALTURA_MAX_CAMINO ? profundidad : ALTURA_MAX_CAMINO - 1]++;
+    if (nodo->key <= min || nodo->key >= max)
+        stats->erroresOrden++;
+
+    int altIzq = validarSubarbol(nodo->left, min, nodo->key, profundidad + 1, stats);
+    int altDer = validarSubarbol(nodo->right, nodo->key, max, profundidad + 1, stats);
+    int alturaReal = 1 + mayor(altIzq, altDer);
+    int desbalance = altIzq > altDer ? altIzq - altDer : altDer - altIzq;
+
+    if (nodo->height != alturaReal)
+        stats->erroresAltura++;
+    if (desbalance > 1)
+        stats->erroresBalance++;
+    if (desbalance > stats->maxDesbalance)
+        stats->maxDesbalance = desbalance;
+    return alturaReal;
+}
+
+/// pre: tareas tiene lugar para 2^PROFUNDIDAD_CORTE elementos
+///post: Agrega como tarea cada subarbol no vacio que cuelga a PROFUNDIDAD_CORTE niveles de la raiz
+void recolectarTareas(struct Node* nodo, long long min, long long max, int profundidad, struct TrabajoValidacion* trabajo) {
+    if (nodo == NULL)
+        return;
+    if (profundidad == PROFUNDIDAD_CORTE) {
+        struct TareaValidacion* tarea = &trabajo->tareas[trabajo->cantidadTareas++];
+        tarea->nodo = nodo;
+        tarea->min = min;
+        tarea->max = max;
+        tarea->profundidad = profundidad;
+        return;
+    }
+    recolectarTareas(nodo->left, min, nodo->key, profundidad + 1, trabajo);
+    recolectarTareas(nodo->right, nodo->key, max, profundidad + 1, trabajo);
+}
+
+/// pre: args es una struct ArgsValidacion
+///post: Procesa tareas hasta que no quede ninguna, acumulando en la parcial del hilo
+DWORD WINAPI threadValidacion(LPVOID args) {
+    struct TrabajoValidacion* trabajo = ((struct ArgsValidacion*)args)->trabajo;
+    struct EstadisticasAVL* stats = ((struct ArgsValidacion*)args)->stats;
+    LONG i;
+
+    while ((i = InterlockedIncrement(&trabajo->siguiente) - 1) < trabajo->cantidadTareas) {
+        struct TareaValidacion* tarea = &trabajo->tareas[i];
+        tarea->alturaReal = validarSubarbol(tarea->nodo, tarea->min, tarea->max, tarea->profundidad, stats);
+    }
+    return 0;
+}
+
+/// pre: Las tareas ya se procesaron - *siguiente: indice de la proxima tarea en el orden de recolectarTareas
+///post: Valida los nodos por encima del corte (se recorren en el mismo orden en que se recolectaron las
+///      tareas, asi cada subarbol del corte toma la altura que midio su tarea) y retorna la altura real
+int validarParteAlta(struct Node* nodo, long long min, long long max, int profundidad,
+                     struct TrabajoValidacion* trabajo, int* siguiente, struct EstadisticasAVL* stats) {
+    if (nodo == NULL)
+        return 0;
+    if (profundidad == PROFUNDIDAD_CORTE)
+        return trabajo->tareas[(*siguiente)++].alturaReal;
+
+    stats->nodos++;
+    stats->sumaProfundidades += profundidad;
+    stats->histograma[profundidad]++;
+    if (nodo->key <= min || nodo->key >= max)
+        stats->erroresOrden++;
+
+    int altIzq = validarParteAlta(nodo->left, min, nodo->key, profundidad + 1, trabajo, siguiente, stats);
+    int altDer = validarParteAlta(nodo->right, nodo->key, max, profundidad + 1, trabajo, siguiente, stats);
+    int alturaReal = 1 + mayor(altIzq, altDer);
+    int desbalance = altIzq > altDer ? altIzq - altDer : altDer - altIzq;
+
+    if (nodo->height != alturaReal)
+        stats->erroresAltura++;
+    if (desbalance > 1)
+        stats->erroresBalance++;
+    if (desbalance > stats->maxDesbalance)
+        stats->maxDesbalance = desbalance;
+    return alturaReal;
+}
+
+/// pre: raiz no debe modificarse mientras dure la validacion - hilos: entre 1 y MAX_HILOS_VALIDACION
+///post: Valida el arbol repartiendo los subarboles entre hilos y deja el resultado en stats
+void validarArbol(struct Node* raiz, int hilos, struct EstadisticasAVL* stats) {
+    struct TrabajoValidacion trabajo;
+    HANDLE handles[MAX_HILOS_VALIDACION];
+    struct ArgsValidacion argumentos[MAX_HILOS_VALIDACION];
+
+    if (hilos < 1)
+        hilos = 1;
+    if (hilos > MAX_HILOS_VALIDACION)
+        hilos = MAX_HILOS_VALIDACION;
+
+    trabajo.tareas = (struct TareaValidacion*)malloc((1 << PROFUNDIDAD_CORTE) * sizeof(struct TareaValidacion));
+    trabajo.cantidadTareas = 0;
+    trabajo.siguiente = 0;
+    trabajo.parciales = (struct EstadisticasAVL*)calloc(hilos, sizeof(struct EstadisticasAVL));
+    recolectarTareas(raiz, LLONG_MIN, LLONG_MAX, 0, &trabajo);
+
+    for (int i = 0; i < hilos; i++) {
+        argumentos[i].trabajo = &trabajo;
+        argumentos[i].stats = &trabajo.parciales[i];
+        handles[i] = CreateThread(NULL, 0, threadValidacion, &argumentos[i], 0, NULL);
+    }
+    for (int i = 0; i < hilos; i++) {
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+    }
+
+    memset(stats, 0, sizeof(struct EstadisticasAVL));
+    int siguiente = 0;
+    stats->altura = validarParteAlta(raiz, LLONG_MIN, LLONG_MAX, 0, &trabajo, &siguiente, stats);
+
+    for (int i = 0; i < hilos; i++) {
+        struct EstadisticasAVL* p = &trabajo.parciales[i];
+        stats->nodos += p->nodos;
+        stats->erroresOrden += p->erroresOrden;
+        stats->erroresAltura += p->erroresAltura;
+        stats->erroresBalance += p->erroresBalance;
+        stats->sumaProfundidades += p->sumaProfundidades;
+        if (p->maxDesbalance > stats->maxDesbalance)
+            stats->maxDesbalance = p->maxDesbalance;
+        for (int d = 0; d < ALTURA_MAX_CAMINO; d++)
+            stats->histograma[d] += p->histograma[d];
+    }
+
+    free(trabajo.tareas);
+    free(trabajo.parciales);
+}
+
+/// pre: stats completada por validarArbol
+///post: Imprime el resultado de la validacion, el largo promedio de busqueda y el histograma de profundidades
+void mostrarEstadisticas(struct EstadisticasAVL* stats, double milisegundos) {
+    int valido = stats->erroresOrden == 0 && stats->erroresAltura == 0 && stats->erroresBalance == 0;
+
+    printf("\n======== VALIDACION DEL ARBOL ========\n");
+    printf("Resultado: %s\n", valido ? "AVL valido" : "ARBOL INVALIDO");
+    printf("Nodos: %lld - Altura: %d\n", stats->nodos, stats->altura);
+    printf("Claves fuera de orden: %lld\n", stats->erroresOrden);
+    printf("Alturas guardadas incorrectas: %lld\n", stats->erroresAltura);
+    printf("Nodos desbalanceados: %lld (maximo |balance| = %d)\n", stats->erroresBalance, stats->maxDesbalance);
+    if (stats->nodos > 0)
+        printf("Largo promedio de busqueda exitosa: %.3lf nodos visitados\n",
+               1.0 + (double)stats->sumaProfundidades / stats->nodos);
+    printf("Tiempo de validacion: %.4lf milisegundos\n", milisegundos);
+
+    printf("| %-11s | %-12s | %-10s |\n", "Profundidad", "Nodos", "% del nivel");
+    printf("|-------------|--------------|------------|\n");
+    for (int d = 0; d < stats->altura && d < ALTURA_MAX_CAMINO; d++) {
+        double capacidadNivel = (d < 62) ? (double)(1LL << d) : 0;
+        printf("| %-11d | %-12lld | %-10.2lf |\n", d, stats->histograma[d],
+               capacidadNivel > 0 ? 100.0 * stats->histograma[d] / capacidadNivel : 0.0);
+    }
+}
+
+
+// ---------------------------------- Argumentos para los hilos ----------------------------------
+#define VENTANA_DESORDEN 8          // Claves casi ordenadas: se desordenan dentro de ventanas de 8
+#define PORCENTAJE_DESORDEN 25      // Ventanas desordenadas sobre el total
+
+// Orden en que el generador produce las claves
+enum OrdenClaves {
+    ORDEN_ALEATORIO,        // Al azar en [min, max]
+    ORDEN_SECUENCIAL,       // inicio, inicio + 1, ... (marcas de tiempo, numeros de secuencia)
+    ORDEN_CASI_ORDENADO     // Secuencial con algunas ventanas permutadas
+};
+const char* nombresOrden[] = {"aleatorio", "secuencial", "casi ordenado"};
+
+struct ThreadArgs {
+    int cantidad;   // Cantidad de valores a insertar
+    int min;        // Valor minimo del rango
+    int max;        // Valor maximo del rango
+    int orden;      // OrdenClaves
+    int inicio;     // Ordenes no aleatorios: primera clave del bloque [inicio, inicio + cantidad) del hilo
 };
 
-// Estructura para almacenar los tiempos de operaciones
-struct TiemposAVL {
-    double tiempoInsercion;
-    double tiempoMostrar;
-    double tiempoBusqueda;
-    double tiempoEliminacion;
-} tiempos = {0, 0, 0, 0};
+/// pre: 0 <= k < cantidad
+///post: Retorna la clave k del bloque [inicio, inicio + cantidad) en el orden pedido (no aleatorio). El
+///      casi ordenado permuta algunas ventanas de VENTANA_DESORDEN claves: cada clave sale una sola vez
+int claveEnOrden(int orden, int inicio, int k, int cantidad) {
+    if (orden == ORDEN_CASI_ORDENADO && (k | (VENTANA_DESORDEN - 1)) < cantidad) {
+        unsigned int h = (unsigned int)(k / VENTANA_DESORDEN) * 2654435761u;
+        if ((h >> 16) % 100 < PORCENTAJE_DESORDEN)
+            k ^= (int)(h >> 29) % VENTANA_DESORDEN | 1;     // XOR dentro de la ventana: es una permutacion
+    }
+    return inicio + k;
+}
+
+/// pre: val: dato a insertar
+///post: Inserta val en el arbol activo segun el modo configurado (AVL estricto, relajado, persistente, con dedo u otro motor),
+///      con el bloqueo que corresponda. Retorna 1 si se inserto, 0 si ya estaba
+int insertarClave(int val) {
+    int insertado = 0;
+
+    trazaAnotar(TRAZA_INSERTAR, val);
+    if (config.motor == MOTOR_BMAS)
+        return bmasInsertar(&arbolBMas, val);
+    if (config.motor == MOTOR_SKIPLIST)
+        return sklInsertar(&listaSkl, val);     // Sin bloqueos: los hilos solo compiten en los CAS
+
+    // Sin modos extra se usa la insercion de la libreria (con la politica fina no toma el arbol entero)
+    if (!config.versionesPersistentes && !config.balanceoRelajado && !config.filtroBloom && !config.insercionConDedo)
+        return avlInsertar(&arbol, val);
+
+    avlBloquearEscritura(&arbol);  // Bloquea el acceso al rbol
+
+    // Con el arbol tomado el filtro no se reconstruye: si dice que no esta, se evita buscar en el arbol
+    int ausente = config.filtroBloom && !filtroConsultar(&filtro, val);
+
+    if (config.versionesPersistentes) {
+        if (ausente || !buscarAVL(versionActual->raiz, val)) {
+            publicarVersion(insertPersistente(versionActual->raiz, val));   // Copia el camino y publica
+            filtroAgregar(val);
+            insertado = 1;
+        }
+    } else if (config.balanceoRelajado) {
+        if (insertRelajado(val)) {          // Solo enlaza la hoja, las rotaciones quedan pendientes
+            filtroAgregar(val);
+            insertado = 1;
+        }
+        if (pendientes.cantidad > UMBRAL_AYUDA)
+            procesarPendientes(1);          // Ayuda al mantenimiento si se esta atrasando
+    } else if (config.insercionConDedo) {
+        if (insertarConDedo(&dedoArbol, &arbol.raiz, val)) {   // La busqueda y la insercion son una sola bajada
+            filtroAgregar(val);
+            insertado = 1;
+        }
+    } else if (ausente || !buscarAVL(arbol.raiz, val)) {    // Solo insertamos dato  no existe
+        arbol.raiz = insert(arbol.raiz, val);   // Inserta valor
+        filtroAgregar(val);
+        insertado = 1;
+    }
+
+    avlLiberarEscritura(&arbol);   // Libera el arbol
+    return insertado;
+}
+
+/// pre: val: dato a eliminar
+///post: Elimina val del arbol activo con el arbol tomado en escritura, o con borrado logico solo lo marca.
+///      Retorna 1 si existia, 0 si no
+int eliminarClave(int val) {
+    int existe;
+
+    trazaAnotar(TRAZA_ELIMINAR, val);
+    if (config.motor == MOTOR_BMAS)
+        return bmasEliminar(&arbolBMas, val);
+    if (config.motor == MOTOR_SKIPLIST)
+        return sklEliminar(&listaSkl, val);
+
+    if (config.borradoLogico) {     // Cuesta lo mismo que una busqueda: no desengancha ni rota
+        if (!avlMarcarBorrado(&arbol, val))
+            return 0;
+        encolarBorrado(val);
+        return 1;
+    }
+
+    avlBloquearEscritura(&arbol);
+    if (config.versionesPersistentes) {
+        existe = buscarAVL(versionActual->raiz, val);
+        if (existe)
+            publicarVersion(deletePersistente(versionActual->raiz, val));
+    } else {
+        existe = buscarAVL(arbol.raiz, val);
+        if (existe) {
+            arbol.raiz = deleteNode(arbol.raiz, val);
+            dedoReiniciar(&dedoArbol);
+        }
+    }
+    if (existe)
+        filtroEliminar();
+    avlLiberarEscritura(&arbol);
+    return existe;
+}
+
+// ---------------------------------- Funcin que ejecuta cada hilo ----------------------------------
+/// pre:
+///post: Cada hilo genera cantidad nmeros entre min y max, y los inserta en el rbol usando mutex para evitar colisiones.
+///      En los ordenes no aleatorios recorre su bloque; si el bloque ya tenia claves completa con aleatorios
+DWORD WINAPI threadInsert(LPVOID args) {
+
+    struct ThreadArgs* ta = (struct ThreadArgs*)args;
+    int inserted = 0;
+    int k = 0;
+
+    while (inserted < ta->cantidad) {
+        int val;
+        if (ta->orden != ORDEN_ALEATORIO && k < ta->cantidad)
+            val = claveEnOrden(ta->orden, ta->inicio, k++, ta->cantidad);
+        else
+            val = rand() % (ta->max - ta->min + 1) + ta->min;
+
+        if (insertarClave(val))
+            inserted++;
+        else
+            AVL_CONTAR(reintentos, 1);  // Clave repetida: otra vuelta del bucle
+    }
+
+    return 0;
+}
+
+void medirTiempoBusqueda(void* arg) {
+    int* val = (int*)arg;
+    buscarAVL(arbol.raiz, *val);
+}
+
+void medirTiempoEliminacion(void* arg) {
+    int* val = (int*)arg;
+    arbol.raiz = deleteNode(arbol.raiz, *val);
+    dedoReiniciar(&dedoArbol);
+}
+
+void medirTiempoMostrar(void* arg) {
+    printInOrder(arbol.raiz);
+}
+
+void medirInsercionConHilos(int total, int threads, int min, int max) {
+    HANDLE hilos[threads];
+    struct ThreadArgs argumentos[threads];
+
+    for (int i = 0; i < threads; i++) {
+        argumentos[i].cantidad = total / threads;
+        argumentos[i].min = min;
+        argumentos[i].max = max;
+        argumentos[i].orden = ORDEN_ALEATORIO;
+    }
+
+    tiempos.tiempoInsercion = medirTiempo((void (*)(void*))threadInsert, &argumentos[0]);
+
+    for (int i = 1; i < threads; i++) {
+        hilos[i] = CreateThread(NULL, 0, threadInsert, &argumentos[i], 0, NULL);
+    }
+
+    // Espera que terminen los hilos
+    for (int i = 1; i < threads; i++) {
+        WaitForSingleObject(hilos[i], INFINITE);
+        CloseHandle(hilos[i]);
+    }
+}
+
+
+// ---------------------------------- Pool de hilos y operaciones asincronas ----------------------------------
+// Los hilos del pool se crean una sola vez al iniciar y esperan operaciones en una cola. Quien envia
+// una operacion sigue con lo suyo y despues la espera (esperarOperacion) o recibe el aviso en alTerminar,
+// asi se pueden encadenar muchas operaciones sin pagar CreateThread/CloseHandle en cada medicion.
+
+#define MAX_HILOS_POOL 64
+
+enum TipoOperacion {
+    OP_INSERTAR,            // key
+    OP_ELIMINAR,            // key
+    OP_BUSCAR,              // key
+    OP_RANGO,               // claves en [key, hasta] copiadas en destino
+    OP_INSERTAR_ALEATORIOS  // lote: lo mismo que hace threadInsert
+};
+
+// Operacion enviada al pool - la memoria es del llamador y debe vivir hasta que termine
+struct OperacionAVL {
+    enum TipoOperacion tipo;
+    int key;
+    int hasta;                  // OP_RANGO: extremo superior inclusivo
+    int* destino;               // OP_RANGO: donde copiar las claves (puede ser NULL para solo contar)
+    int capacidad;              // OP_RANGO: lugar en destino
+    struct ThreadArgs* lote;    // OP_INSERTAR_ALEATORIOS
+    int resultado;              // 1/0 si se inserto, elimino o encontro - OP_RANGO: claves en el rango
+    void (*alTerminar)(struct OperacionAVL*);  // Opcional: se llama desde el hilo del pool
+    void* contexto;             // Libre para el llamador (por ejemplo para alTerminar)
+    volatile LONG terminada;
+    struct OperacionAVL* siguiente;
+};
+
+struct PoolHilos {
+    HANDLE hilos[MAX_HILOS_POOL];
+    int cantidad;
+    CRITICAL_SECTION lock;          // Protege la cola y fin
+    CONDITION_VARIABLE hayTrabajo;
+    CONDITION_VARIABLE hayTerminadas;
+    struct OperacionAVL* primera;   // Cola FIFO de operaciones pendientes
+    struct OperacionAVL* ultima;
+    int fin;
+} pool;
+
+/// pre: nodo: subarbol a recorrer - desde/hasta: rango inclusivo
+///post: Copia en orden las claves del rango (hasta capacidad) y retorna cuantas hay en total
+int recolectarRango(struct Node* nodo, int desde, int hasta, int* destino, int capacidad, int encontradas) {
+    if (nodo == NULL)
+        return encontradas;
+    if (desde < nodo->key)
+        encontradas = recolectarRango(nodo->left, desde, hasta, destino, capacidad, encontradas);
+    if (nodo->key >= desde && nodo->key <= hasta && !nodoBorrado(nodo)) {
+        if (destino != NULL && encontradas < capacidad)
+            destino[encontradas] = nodo->key;
+        encontradas++;
+    }
+    if (hasta > nodo->key)
+        encontradas = recolectarRango(nodo->right, desde, hasta, destino, capacidad, encontradas);
+    return encontradas;
+}
+
+/// pre: desde <= hasta
+///post: Busca las claves del rango en el arbol activo (version fijada o con bloqueo de lectura) y retorna cuantas hay
+int buscarRango(int desde, int hasta, int* destino, int capacidad) {
+    if (config.motor == MOTOR_BMAS) {
+        bmasBloquearLectura(&arbolBMas);
+        int encontradas = bmasRango(arbolBMas.raiz, desde, hasta, destino, capacidad);
+        bmasLiberarLectura(&arbolBMas);
+        return encontradas;
+    }
+    if (config.motor == MOTOR_SKIPLIST)
+        return sklRango(&listaSkl, desde, hasta, destino, capacidad);
+    struct VersionAVL* version = abrirLectura();
+    int encontradas = recolectarRango(version ? version->raiz : arbol.raiz, desde, hasta, destino, capacidad, 0);
+    cerrarLectura(version);
+    return encontradas;
+}
+
+/// pre: op fue tomada de la cola por un hilo del pool
+///post: Ejecuta la operacion, marca que termino y avisa a quien la espere
+void ejecutarOperacion(struct OperacionAVL* op) {
+    switch (op->tipo) {
+        case OP_INSERTAR:
+            op->resultado = insertarClave(op->key);
+            break;
+        case OP_ELIMINAR:
+            op->resultado = eliminarClave(op->key);
+            break;
+        case OP_BUSCAR:
+            op->resultado = buscarConFiltro(op->key);
+            break;
+        case OP_RANGO:
+            op->resultado = buscarRango(op->key, op->hasta, op->destino, op->capacidad);
+            break;
+        case OP_INSERTAR_ALEATORIOS:
+            threadInsert(op->lote);
+            op->resultado = op->lote->cantidad;
+            break;
+    }
+
+    if (op->alTerminar != NULL)
+        op->alTerminar(op);
+
+    EnterCriticalSection(&pool.lock);
+    op->terminada = 1;
+    WakeAllConditionVariable(&pool.hayTerminadas);
+    LeaveCriticalSection(&pool.lock);
+}
+
+/// pre: Se lanza desde agrandarPool
+///post: Toma operaciones de la cola y las ejecuta hasta que se cierre el pool
+DWORD WINAPI threadPool(LPVOID args) {
+    EnterCriticalSection(&pool.lock);
+    while (1) {
+        while (pool.primera == NULL && !pool.fin)
+            SleepConditionVariableCS(&pool.hayTrabajo, &pool.lock, INFINITE);
+        if (pool.primera == NULL)
+            break;  // Se pidio cerrar y no queda trabajo
+
+        struct OperacionAVL* op = pool.primera;
+        pool.primera = op->siguiente;
+        if (pool.primera == NULL)
+            pool.ultima = NULL;
+
+        LeaveCriticalSection(&pool.lock);
+        ejecutarOperacion(op);
+        EnterCriticalSection(&pool.lock);
+    }
+    LeaveCriticalSection(&pool.lock);
+    return 0;
+}
+
+/// pre: Solo desde el hilo del menu
+///post: Lanza hilos hasta que el pool tenga al menos cantidad (como maximo MAX_HILOS_POOL)
+void agrandarPool(int cantidad) {
+    if (cantidad > MAX_HILOS_POOL)
+        cantidad = MAX_HILOS_POOL;
+    while (pool.cantidad < cantidad) {
+        pool.hilos[pool.cantidad] = CreateThread(NULL, 0, threadPool, NULL, 0, NULL);
+        pool.cantidad++;
+    }
+}
+
+/// pre: hilos: cantidad inicial de hilos
+///post: Inicializa la cola y lanza los hilos del pool
+void iniciarPool(int hilos) {
+    InitializeCriticalSection(&pool.lock);
+    InitializeConditionVariable(&pool.hayTrabajo);
+    InitializeConditionVariable(&pool.hayTerminadas);
+    pool.primera = pool.ultima = NULL;
+    pool.cantidad = 0;
+    pool.fin = 0;
+    agrandarPool(hilos);
+}
+
+/// pre: ops: cantidad operaciones completas (tipo y datos), que no deben tocarse hasta que terminen
+///post: Encola todas de una vez (una sola toma del lock) y retorna sin esperar
+void enviarOperaciones(struct OperacionAVL* ops, int cantidad) {
+    if (cantidad <= 0)
+        return;
+    for (int i = 0; i < cantidad; i++) {
+        ops[i].terminada = 0;
+        ops[i].siguiente = (i + 1 < cantidad) ? &ops[i + 1] : NULL;
+    }
+
+    EnterCriticalSection(&pool.lock);
+    if (pool.ultima != NULL)
+        pool.ultima->siguiente = &ops[0];
+    else
+        pool.primera = &ops[0];
+    pool.ultima = &ops[cantidad - 1];
+    if (cantidad == 1)
+        WakeConditionVariable(&pool.hayTrabajo);
+    else
+        WakeAllConditionVariable(&pool.hayTrabajo);
+    LeaveCriticalSection(&pool.lock);
+}
+
+/// pre: op fue enviada con enviarOperaciones
+///post: Bloquea hasta que op termine y retorna su resultado
+int esperarOperacion(struct OperacionAVL* op) {
+    if (!op->terminada) {
+        EnterCriticalSection(&pool.lock);
+        while (!op->terminada)
+            SleepConditionVariableCS(&pool.hayTerminadas, &pool.lock, INFINITE);
+        LeaveCriticalSection(&pool.lock);
+    }
+    return op->resultado;
+}
+
+/// pre:
+///post: Espera a que se vacie la cola, detiene los hilos del pool y libera sus recursos
+void cerrarPool() {
+    EnterCriticalSection(&pool.lock);
+    pool.fin = 1;
+    WakeAllConditionVariable(&pool.hayTrabajo);
+    LeaveCriticalSection(&pool.lock);
+
+    for (int i = 0; i < pool.cantidad; i++) {
+        WaitForSingleObject(pool.hilos[i], INFINITE);
+        CloseHandle(pool.hilos[i]);
+    }
+    DeleteCriticalSection(&pool.lock);
+}
+
+/// pre: op termino - op->contexto apunta a un contador LONG
+///post: Suma el resultado de op al contador (ejemplo de aviso por callback)
+void contarResultado(struct OperacionAVL* op) {
+    InterlockedExchangeAdd((volatile LONG*)op->contexto, op->resultado);
+}
+
+/// pre: cantidad > 0 - min <= max - lote: operaciones enviadas antes de esperar
+///post: Envia cantidad operaciones mezcladas (50% busquedas, 30% inserciones, 20% eliminaciones) al pool
+///      en lotes sin esperar cada una, y muestra operaciones por segundo y aciertos contados por callback
+void benchmarkAsincrono(int cantidad, int min, int max, int lote) {
+    struct OperacionAVL* ops = (struct OperacionAVL*)calloc(lote, sizeof(struct OperacionAVL));
+    volatile LONG aciertos = 0;
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+
+    QueryPerformanceCounter(&start);
+    for (int enviadas = 0; enviadas < cantidad; enviadas += lote) {
+        int n = (cantidad - enviadas < lote) ? cantidad - enviadas : lote;
+        for (int i = 0; i < n; i++) {
+            int dado = rand() % 100;
+            ops[i].tipo = dado < 50 ? OP_BUSCAR : (dado < 80 ? OP_INSERTAR : OP_ELIMINAR);
+            ops[i].key = rand() % (max - min + 1) + min;
+            ops[i].alTerminar = contarResultado;
+            ops[i].contexto = (void*)&aciertos;
+        }
+        enviarOperaciones(ops, n);
+        for (int i = 0; i < n; i++)     // Antes de reutilizar el lote espera que terminen todas
+            esperarOperacion(&ops[i]);
+    }
+    QueryPerformanceCounter(&end);
+
+    double segundos = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    printf("Operaciones: %d en %.4lf milisegundos (%.0lf ops/s) con %d hilos en el pool\n",
+           cantidad, segundos * 1000.0, cantidad / segundos, pool.cantidad);
+    printf("Operaciones con exito (insertadas, encontradas o eliminadas): %ld\n", (long)aciertos);
+    free(ops);
+}
+
+
+// ---------------------------------- Comparacion de motores ----------------------------------
+// Corre la misma carga (mismas claves, mismas consultas, mismo orden) sobre un AVL y un B+ locales,
+// sin bloqueos ni hilos, para comparar solo el costo de la estructura.
+
+// Estado compartido por las fases medidas con medirTiempo
+struct CargaMotores {
+    int* claves;            // Claves a insertar y despues a eliminar
+    int* consultas;         // Mitad claves insertadas, mitad valores al azar
+    int cantidad;
+    struct Node* raizAVL;
+    struct NodoBMas* raizBMas;
+    volatile int resultado; // Evita que el compilador descarte las busquedas
+};
+
+void cargarAVL(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    for (int i = 0; i < c->cantidad; i++)
+        if (!buscarAVL(c->raizAVL, c->claves[i]))
+            c->raizAVL = insert(c->raizAVL, c->claves[i]);
+}
+
+void cargarBMas(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    int insertado;
+    for (int i = 0; i < c->cantidad; i++)
+        c->raizBMas = bmasInsert(c->raizBMas, c->claves[i], &insertado);
+}
+
+void consultarAVL(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    for (int i = 0; i < c->cantidad; i++)
+        c->resultado += buscarAVL(c->raizAVL, c->consultas[i]);
+}
+
+void consultarBMas(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    for (int i = 0; i < c->cantidad; i++)
+        c->resultado += bmasBuscar(c->raizBMas, c->consultas[i]);
+}
+
+void recorrerAVL(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    c->resultado += recolectarRango(c->raizAVL, INT_MIN, INT_MAX, NULL, 0, 0);
+}
+
+void recorrerBMas(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    c->resultado += bmasRango(c->raizBMas, INT_MIN, INT_MAX, NULL, 0);
+}
+
+void vaciarAVL(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    for (int i = 0; i < c->cantidad; i++)
+        c->raizAVL = deleteNode(c->raizAVL, c->claves[i]);
+}
+
+void vaciarBMas(void* args) {
+    struct CargaMotores* c = (struct CargaMotores*)args;
+    int eliminado;
+    for (int i = 0; i < c->cantidad; i++)
+        c->raizBMas = bmasDelete(c->raizBMas, c->claves[i], &eliminado);
+}
+
+/// pre: cantidad > 0 - min <= max
+///post: Inserta cantidad claves al azar en [min, max], hace cantidad busquedas, un recorrido en orden
+///      y elimina todas las claves en ambos motores. Muestra tiempos y memoria de cada uno
+void compararMotores(int cantidad, int min, int max) {
+    static const char* fases[] = {"Insercion", "Busqueda (50% aciertos)", "Recorrido en orden", "Eliminacion"};
+    void (*funcionesAVL[])(void*) = {cargarAVL, consultarAVL, recorrerAVL, vaciarAVL};
+    void (*funcionesBMas[])(void*) = {cargarBMas, consultarBMas, recorrerBMas, vaciarBMas};
+    struct CargaMotores carga = {NULL, NULL, cantidad, NULL, NULL, 0};
+    long long rango = (long long)max - min + 1;
+    double ms[4][2];
+    struct MemoriaCategoria antes[2], despues[2];   // Contabilidad de cada motor alrededor de la carga
+    int claves = 0;
+
+    carga.claves = (int*)malloc(cantidad * sizeof(int));
+    carga.consultas = (int*)malloc(cantidad * sizeof(int));
+    for (int i = 0; i < cantidad; i++)
+        carga.claves[i] = (int)(min + (((unsigned)rand() << 15) ^ (unsigned)rand()) % rango);  // rand() puede devolver solo 15 bits
+    for (int i = 0; i < cantidad; i++)
+        carga.consultas[i] = (i % 2 == 0) ? carga.claves[(((unsigned)rand() << 15) ^ (unsigned)rand()) % cantidad]
+                                          : (int)(min + (((unsigned)rand() << 15) ^ (unsigned)rand()) % rango);
+
+    vaciarPapelera(0);      // Que el mantenimiento no libere nodos AVL en medio de la medicion
+    memoriaLeer(MEMORIA_AVL, &antes[0]);
+    memoriaLeer(MEMORIA_BMAS, &antes[1]);
+    for (int f = 0; f < 4; f++) {
+        ms[f][0] = medirTiempo(funcionesAVL[f], &carga);
+        if (f == 0) {
+            memoriaLeer(MEMORIA_AVL, &despues[0]);
+            claves = contarNodos(carga.raizAVL);   // Sin las repetidas
+        }
+        ms[f][1] = medirTiempo(funcionesBMas[f], &carga);
+        if (f == 0)
+            memoriaLeer(MEMORIA_BMAS, &despues[1]);
+    }
+    long long pedidos[2], heap[2];
+    for (int m = 0; m < 2; m++) {
+        pedidos[m] = despues[m].pedidos - antes[m].pedidos;
+        heap[m] = despues[m].heap - antes[m].heap;
+    }
+
+    printf("\n======== AVL vs B+ (%d claves, nodo B+ de %d bytes) ========\n", cantidad, BMAS_BYTES_NODO);
+    printf("| %-25s | %-12s | %-12s | %-8s |\n", "Operacion", "AVL (ms)", "B+ (ms)", "AVL/B+");
+    printf("|---------------------------|--------------|--------------|----------|\n");
+    for (int f = 0; f < 4; f++)
+        printf("| %-25s | %-12.4lf | %-12.4lf | %-8.2lf |\n", fases[f], ms[f][0], ms[f][1], ms[f][0] / ms[f][1]);
+    printf("| %-25s | %-12lld | %-12lld | %-8.2lf |\n", "Bytes pedidos", pedidos[0], pedidos[1],
+           (double)pedidos[0] / pedidos[1]);
+    printf("| %-25s | %-12lld | %-12lld | %-8.2lf |\n", "Bytes en el heap", heap[0], heap[1], (double)heap[0] / heap[1]);
+    printf("| %-25s | %-12.2lf | %-12.2lf | %-8.2lf |\n", "Heap por clave (bytes)",
+           (double)heap[0] / claves, (double)heap[1] / claves, (double)heap[0] / heap[1]);
+
+    free(carga.claves);
+    free(carga.consultas);
+}
+
+/// pre: Las versiones persistentes estan desactivadas y el servidor detenido - destino: MotorArbol
+///post: Pasa todas las claves del motor activo a destino y lo deja activo. El filtro de Bloom se
+///      desactiva al dejar el AVL porque solo sigue las claves del AVL
+void cambiarMotor(int destino) {
+    int cantidad = 0;
+    int* claves = NULL;
+    int insertado;
+
+    drenarRebalanceo();
+    avlBloquearEscritura(&arbol);
+    bmasBloquearEscritura(&arbolBMas);
+
+    // Saca las claves ordenadas del motor activo y lo deja vacio
+    if (config.motor == MOTOR_AVL) {
+        claves = (int*)malloc(contarNodos(arbol.raiz) * sizeof(int));
+        cantidad = recolectarClaves(arbol.raiz, claves, 0);     // Los borrados logicos no pasan
+        liberarArbol(arbol.raiz);
+        arbol.raiz = NULL;
+        if (config.filtroBloom) {
+            filtroDescartar();
+            config.filtroBloom = 0;
+        }
+    } else if (config.motor == MOTOR_BMAS) {
+        cantidad = bmasContarClaves(arbolBMas.raiz);    // Las hojas enlazadas ya dan las claves ordenadas
+        claves = (int*)malloc(cantidad * sizeof(int));
+        bmasRango(arbolBMas.raiz, INT_MIN, INT_MAX, claves, cantidad);
+        bmasLiberar(arbolBMas.raiz);
+        arbolBMas.raiz = NULL;
+    } else {
+        cantidad = sklContar(&listaSkl, NULL, NULL);
+        claves = (int*)malloc(cantidad * sizeof(int));
+        sklRango(&listaSkl, INT_MIN, INT_MAX, claves, cantidad);
+        sklVaciar(&listaSkl);
+    }
+
+    for (int i = 0; i < cantidad; i++) {
+        if (destino == MOTOR_AVL)
+            arbol.raiz = insert(arbol.raiz, claves[i]);
+        else if (destino == MOTOR_BMAS)
+            arbolBMas.raiz = bmasInsert(arbolBMas.raiz, claves[i], &insertado);
+        else
+            sklInsertar(&listaSkl, claves[i]);
+    }
+    config.motor = destino;
+    dedoReiniciar(&dedoArbol);
+    free(claves);
+
+    bmasLiberarEscritura(&arbolBMas);
+    avlLiberarEscritura(&arbol);
+}
+
+// Consultas del menu para los motores B+ y skip list (el AVL tiene las suyas en cada opcion)
+
+/// pre: config.motor != MOTOR_AVL
+///post: Retorna 1 si el motor activo no tiene claves
+int motorVacio() {
+    if (config.motor == MOTOR_SKIPLIST)
+        return sklVacia(&listaSkl);
+    bmasBloquearLectura(&arbolBMas);
+    int vacio = arbolBMas.raiz == NULL;
+    bmasLiberarLectura(&arbolBMas);
+    return vacio;
+}
+
+/// pre: config.motor != MOTOR_AVL
+///post: Imprime las claves en orden: hojas enlazadas del B+ o nivel 0 de la skip list
+void imprimirMotor() {
+    if (config.motor == MOTOR_SKIPLIST) {
+        sklPrintInOrder(&listaSkl);
+        return;
+    }
+    bmasBloquearLectura(&arbolBMas);
+    bmasPrintInOrder(arbolBMas.raiz);
+    bmasLiberarLectura(&arbolBMas);
+}
+
+/// pre: config.motor != MOTOR_AVL
+///post: Retorna el nivel donde esta valor o -1. En el B+ todas las claves estan en las hojas
+///      y en la skip list en el nivel 0
+int buscarNivelMotor(int valor) {
+    if (config.motor == MOTOR_SKIPLIST)
+        return sklContiene(&listaSkl, valor) ? 0 : -1;
+    bmasBloquearLectura(&arbolBMas);
+    int nivel = bmasBuscar(arbolBMas.raiz, valor) ? bmasAltura(arbolBMas.raiz) - 1 : -1;
+    bmasLiberarLectura(&arbolBMas);
+    return nivel;
+}
+
+/// pre: config.motor != MOTOR_AVL
+///post: Muestra cantidad de claves, nodos, altura o niveles y memoria del motor activo
+void mostrarTamanioMotor() {
+    if (config.motor == MOTOR_SKIPLIST) {
+        size_t memoria;
+        int nivelMaximo;
+        int claves = sklContar(&listaSkl, &memoria, &nivelMaximo);
+        if (claves == 0) {
+            printf("El arbol esta vacio.\n");
+            return;
+        }
+        printf("Niveles de la skip list: %d\n", nivelMaximo);
+        printf("Cantidad de claves: %d\n", claves);
+        memoriaMostrar(stdout, MEMORIA_SKIPLIST, claves);   // Incluye retirados que aun no se liberaron
+        return;
+    }
+
+    bmasBloquearLectura(&arbolBMas);
+    if (arbolBMas.raiz == NULL) {
+        printf("El arbol esta vacio.\n");
+    } else {
+        int nodos = bmasContarNodos(arbolBMas.raiz);
+        int claves = bmasContarClaves(arbolBMas.raiz);
+        printf("Altura del arbol B+: %d\n", bmasAltura(arbolBMas.raiz));
+        printf("Cantidad de claves: %d\n", claves);
+        printf("Cantidad de nodos: %d (de %d bytes)\n", nodos, BMAS_BYTES_NODO);
+        memoriaMostrar(stdout, MEMORIA_BMAS, claves);
+    }
+    bmasLiberarLectura(&arbolBMas);
+}
+
+/// pre: config.motor != MOTOR_AVL
+///post: Borra todas las claves del motor activo. Retorna 0 si ya estaba vacio
+int reiniciarMotor() {
+    if (config.motor == MOTOR_SKIPLIST) {
+        if (sklVacia(&listaSkl))
+            return 0;
+        sklVaciar(&listaSkl);   // Los hilos del servidor pueden seguir usandola
+        return 1;
+    }
+    bmasBloquearEscritura(&arbolBMas);
+    int habia = arbolBMas.raiz != NULL;
+    bmasLiberar(arbolBMas.raiz);
+    arbolBMas.raiz = NULL;
+    bmasLiberarEscritura(&arbolBMas);
+    return habia;
+}
+
+
+// ---------------------------------- Claves casi ordenadas ----------------------------------
+// Inserta y busca las mismas claves en un AVL local desde la raiz (insert, buscarAVL) y con dedo
+// (insertarConDedo, buscarConDedo), para cada orden del generador. Con claves ordenadas o casi
+// ordenadas el dedo ahorra la bajada desde la raiz; con claves al azar sube casi siempre hasta la
+// raiz y ademas paga guardar el camino, asi que ahi pierde.
+
+/// pre: cantidad > 0
+///post: Muestra los tiempos de insercion y busqueda desde la raiz y con dedo para cada orden de claves
+void benchmarkDedo(int cantidad) {
+    int* claves = (int*)malloc(cantidad * sizeof(int));
+    double ms[3][4];
+    LARGE_INTEGER frecuencia, t0, t1;
+    volatile int encontradas = 0;
+
+    QueryPerformanceFrequency(&frecuencia);
+    for (int orden = ORDEN_ALEATORIO; orden <= ORDEN_CASI_ORDENADO; orden++) {
+        for (int i = 0; i < cantidad; i++)
+            claves[i] = (orden == ORDEN_ALEATORIO) ? (int)((((unsigned)rand() << 15) ^ (unsigned)rand()) % (4u * cantidad))
+                                                   : claveEnOrden(orden, 0, i, cantidad);
+
+        for (int conDedo = 0; conDedo <= 1; conDedo++) {
+            struct Node* raiz = NULL;
+            struct DedoAVL dedo;
+            dedoReiniciar(&dedo);
+
+            QueryPerformanceCounter(&t0);
+            for (int i = 0; i < cantidad; i++) {
+                if (conDedo)
+                    insertarConDedo(&dedo, &raiz, claves[i]);
+                else
+                    raiz = insert(raiz, claves[i]);
+            }
+            QueryPerformanceCounter(&t1);
+            ms[orden][conDedo] = (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / frecuencia.QuadPart;
+
+            QueryPerformanceCounter(&t0);
+            for (int i = 0; i < cantidad; i++)
+                encontradas += conDedo ? buscarConDedo(&dedo, &raiz, claves[i]) : buscarAVL(raiz, claves[i]);
+            QueryPerformanceCounter(&t1);
+            ms[orden][2 + conDedo] = (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / frecuencia.QuadPart;
+
+            liberarArbol(raiz);
+        }
+    }
+    free(claves);
+
+    printf("\n======== Insercion y busqueda con dedo (%d claves) ========\n", cantidad);
+    printf("| %-14s | %-13s | %-13s | %-7s | %-13s | %-13s | %-7s |\n", "Orden",
+           "Ins. raiz ms", "Ins. dedo ms", "Mejora", "Busq. raiz ms", "Busq. dedo ms", "Mejora");
+    printf("|----------------|---------------|---------------|---------|---------------|---------------|---------|\n");
+    for (int orden = ORDEN_ALEATORIO; orden <= ORDEN_CASI_ORDENADO; orden++)
+        printf("| %-14s | %-13.3lf | %-13.3lf | %-7.2lf | %-13.3lf | %-13.3lf | %-7.2lf |\n", nombresOrden[orden],
+               ms[orden][0], ms[orden][1], ms[orden][0] / ms[orden][1], ms[orden][2], ms[orden][3], ms[orden][2] / ms[orden][3]);
+}
+
+// ---------------------------------- Expiracion por rangos ----------------------------------
+// Quitar todas las claves de un rango (por ejemplo las que quedaron por debajo de una marca de agua)
+// con deleteNode es una bajada y un rebalanceo por clave, todo con el arbol tomado. Con el AVL se
+// parte y se une (extraerRango): el arbol queda tomado O(log n) sin importar cuantas claves salgan, y
+// el subarbol extraido va a la papelera, que el hilo de mantenimiento libera sin tomar el arbol.
+// B+, skip list y el modo persistente (los nodos se comparten con versiones viejas) no parten:
+// ahi se borra clave por clave.
+
+/// pre: desde <= hasta - extraido: NULL para eliminar, o donde dejar un AVL con las claves quitadas
+///post: Quita del motor activo las claves de [desde, hasta]. Sin extraido, los nodos del AVL se liberan
+///      despues en segundo plano; con extraido, quien llama libera lo que recibe. Retorna 1 si quito alguna
+int eliminarRango(int desde, int hasta, struct Node** extraido) {
+    if (config.motor != MOTOR_AVL || config.versionesPersistentes) {
+        int cantidad = buscarRango(desde, hasta, NULL, 0);
+        int* claves = (int*)malloc((cantidad + 1) * sizeof(int));
+        int quitadas = 0;
+        cantidad = buscarRango(desde, hasta, claves, cantidad);     // Se pudo insertar entre medio: se
+        for (int i = 0; i < cantidad; i++) {                        // quitan solo las de la primera cuenta
+            if (eliminarClave(claves[i]))
+                claves[quitadas++] = claves[i];
+        }
+        if (extraido != NULL)
+            *extraido = construirOrdenado(claves, quitadas);
+        free(claves);
+        return quitadas > 0;
+    }
+
+    avlBloquearEscritura(&arbol);
+    if (config.balanceoRelajado)
+        procesarPendientes(CAPACIDAD_PENDIENTES);   // Partir y unir necesitan las alturas al dia
+    struct Node* rango = extraerRango(&arbol.raiz, desde, hasta);
+    if (rango != NULL)
+        dedoReiniciar(&dedoArbol);
+    if (rango != NULL && extraido != NULL)
+        filtroEliminarVarias(contarNodos(rango));   // Los de la papelera los cuenta vaciarPapelera
+    avlLiberarEscritura(&arbol);
+
+    if (extraido != NULL) {
+        *extraido = rango;
+    } else if (rango != NULL) {
+        papeleraAgregar(&papelera, rango);
+        SetEvent(eventoRebalanceo);
+    }
+    return rango != NULL;
+}
+
+/// pre: cantidad > 1
+///post: Arma dos AVL con las claves 0..cantidad-1 y expira en cada uno el mismo porcentaje de claves
+///      mas chicas: uno con deleteNode por clave y otro partiendo y uniendo. Muestra cuanto tiempo
+///      queda tomado el arbol en cada caso, lo que tarda la liberacion diferida y la forma resultante
+void benchmarkExpiracion(int cantidad) {
+    const int porcentajes[] = {1, 10, 50, 90};
+    int* claves = (int*)malloc(cantidad * sizeof(int));
+    LARGE_INTEGER frecuencia, t0, t1, t2;
+    struct PapeleraAVL local;
+
+    QueryPerformanceFrequency(&frecuencia);
+    papeleraInicializar(&local);
+    for (int i = 0; i < cantidad; i++)
+        claves[i] = i;
+
+    printf("\n======== Expiracion de las claves mas chicas (%d claves) ========\n", cantidad);
+    printf("| %-5s | %-16s | %-16s | %-15s | %-8s | %-8s |\n", "%", "Metodo", "Arbol tomado ms", "Liberacion ms", "Quedan", "Altura");
+    printf("|-------|------------------|------------------|-----------------|----------|----------|\n");
+    for (int p = 0; p < (int)(sizeof(porcentajes) / sizeof(porcentajes[0])); p++) {
+        int marca = (int)((long long)cantidad * porcentajes[p] / 100);  // Se expiran las claves < marca
+
+        struct Node* raiz = construirOrdenado(claves, cantidad);
+        QueryPerformanceCounter(&t0);
+        for (int k = 0; k < marca; k++)
+            raiz = deleteNode(raiz, k);
+        QueryPerformanceCounter(&t1);
+        printf("| %-5d | %-16s | %-16.3lf | %-15s | %-8d | %-8d |\n", porcentajes[p], "clave por clave",
+               (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / frecuencia.QuadPart, "-", contarNodos(raiz), calcularAltura(raiz));
+        liberarArbol(raiz);
+
+        raiz = construirOrdenado(claves, cantidad);
+        QueryPerformanceCounter(&t0);
+        struct Node* rango = marca > 0 ? extraerRango(&raiz, 0, marca - 1) : NULL;
+        QueryPerformanceCounter(&t1);
+        papeleraAgregar(&local, rango);
+        papeleraLiberar(&local, 0);
+        QueryPerformanceCounter(&t2);
+        printf("| %-5d | %-16s | %-16.3lf | %-15.3lf | %-8d | %-8d |\n", porcentajes[p], "partir y unir",
+               (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / frecuencia.QuadPart,
+               (double)(t2.QuadPart - t1.QuadPart) * 1000.0 / frecuencia.QuadPart, contarNodos(raiz), calcularAltura(raiz));
+        liberarArbol(raiz);
+    }
+    free(claves);
+}
+
+
+// ---------------------------------- Contadores de estructura ----------------------------------
+// Suma de los contadores por hilo de la libreria (AVL_CONTADORES): la opcion 7 los muestra desde el
+// inicio o desde la ultima medicion del escalado, que los reinicia para guardarlos por medicion.
+
+/// pre: salida abierta para escribir
+///post: Escribe la tabla de contadores de estructura, o un aviso si se compilo sin AVL_CONTADORES
+void escribirContadores(FILE* salida) {
+#if AVL_CONTADORES
+    struct ContadoresAVL e;
+    avlContadoresSumar(&e);
+
+    fprintf(salida, "\n======== CONTADORES DE ESTRUCTURA ========\n");
+    fprintf(salida, "| %-32s | %-14s |\n", "Contador", "Valor");
+    fprintf(salida, "|----------------------------------|----------------|\n");
+    fprintf(salida, "| %-32s | %-14lld |\n", "Rotaciones simples", e.rotacionesSimples);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Rotaciones dobles", e.rotacionesDobles);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Busquedas", e.busquedas);
+    fprintf(salida, "| %-32s | %-14.3lf |\n", "Nodos visitados por busqueda",
+            e.busquedas ? (double)e.nodosVisitados / e.busquedas : 0.0);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Rebalanceos", e.rebalanceos);
+    fprintf(salida, "| %-32s | %-14.3lf |\n", "Niveles por rebalanceo",
+            e.rebalanceos ? (double)e.nivelesRebalanceo / e.rebalanceos : 0.0);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Nivel maximo de rebalanceo", e.nivelMaximoRebalanceo);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Reintentos de insercion", e.reintentos);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Nodos reservados", e.reservas);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Nodos liberados", e.liberaciones);
+#else
+    fprintf(salida, "\nContadores de estructura desactivados: compilar con -DAVL_CONTADORES=1\n");
+#endif
+}
+
+/// pre: salida abierta para escribir
+///post: Escribe los contadores sumados como objeto JSON, o null si se compilo sin AVL_CONTADORES
+void escribirContadoresJSON(FILE* salida) {
+#if AVL_CONTADORES
+    struct ContadoresAVL e;
+    avlContadoresSumar(&e);
+    fprintf(salida, "{\"rotacionesSimples\": %lld, \"rotacionesDobles\": %lld, \"busquedas\": %lld, "
+                    "\"nodosVisitados\": %lld, \"rebalanceos\": %lld, \"nivelesRebalanceo\": %lld, "
+                    "\"nivelMaximoRebalanceo\": %lld, \"reintentos\": %lld, \"reservas\": %lld, \"liberaciones\": %lld}",
+            e.rotacionesSimples, e.rotacionesDobles, e.busquedas, e.nodosVisitados, e.rebalanceos,
+            e.nivelesRebalanceo, e.nivelMaximoRebalanceo, e.reintentos, e.reservas, e.liberaciones);
+#else
+    fprintf(salida, "null");
+#endif
+}
+
+
+// ---------------------------------- Escalado por cantidad de hilos ----------------------------------
+// Misma mezcla de operaciones (70% busquedas, 20% inserciones, 10% eliminaciones) con 1 a 64 hilos
+// sobre un AVL, un B+ y la skip list locales, cada uno con el bloqueo de su motor. Muestra cuantas
+// operaciones por segundo sostiene cada motor a medida que crece la contencion. Con la politica mutex
+// el AVL y el B+ usan el cerrojo elegido y se agrega una columna con el AVL usando el otro, ademas
+// del costo de tomar y soltar cada cerrojo sin contencion. Cada medicion se guarda tambien en
+// ARCHIVO_ESCALADO con los contadores de estructura de esa medicion.
+
+#define ESCALADO_PASOS 7
+#define ESCALADO_HILOS_MAXIMO 64
+#define ARCHIVO_ESCALADO "concurrente_escalado_avl.json"
+
+struct ArgsEscalado {
+    int motor;                  // MotorArbol a usar
+    struct ArbolAVL* avl;
+    struct ArbolBMas* bmas;
+    struct ListaSkl* skl;
+    int operaciones;            // Operaciones de este hilo
+    int rango;                  // Claves en [0, rango)
+    unsigned int semilla;       // Generador propio: rand() no es seguro entre hilos
+    HANDLE largada;             // Evento manual: todos los hilos arrancan juntos
+};
+
+/// pre: motor es un MotorArbol y su estructura esta inicializada - operacion es una OperacionTraza
+///post: Aplica la operacion al motor local con el bloqueo de ese motor. Retorna 1 si inserto, encontro o elimino
+int operarMotorLocal(int motor, struct ArbolAVL* avl, struct ArbolBMas* bmas, struct ListaSkl* skl, int operacion, int key) {
+    if (motor == MOTOR_AVL) {
+        if (operacion == TRAZA_BUSCAR) return avlContiene(avl, key);
+        if (operacion == TRAZA_INSERTAR) return avlInsertar(avl, key);
+        return avlEliminar(avl, key);
+    }
+    if (motor == MOTOR_BMAS) {
+        if (operacion == TRAZA_BUSCAR) return bmasContiene(bmas, key);
+        if (operacion == TRAZA_INSERTAR) return bmasInsertar(bmas, key);
+        return bmasEliminar(bmas, key);
+    }
+    if (operacion == TRAZA_BUSCAR) return sklContiene(skl, key);
+    if (operacion == TRAZA_INSERTAR) return sklInsertar(skl, key);
+    return sklEliminar(skl, key);
+}
+
+DWORD WINAPI threadEscalado(LPVOID arg) {
+    struct ArgsEscalado* a = (struct ArgsEscalado*)arg;
+    unsigned int x = a->semilla;
+
+    WaitForSingleObject(a->largada, INFINITE);
+    for (int i = 0; i < a->operaciones; i++) {
+        x = x * 1103515245u + 12345u;
+        unsigned int tipo = (x >> 16) % 10;
+        x = x * 1103515245u + 12345u;
+        int key = (int)((x >> 8) % (unsigned int)a->rango);
+
+        operarMotorLocal(a->motor, a->avl, a->bmas, a->skl,
+                         tipo < 7 ? TRAZA_BUSCAR : tipo < 9 ? TRAZA_INSERTAR : TRAZA_ELIMINAR, key);
+    }
+    return 0;
+}
+
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+#define ESCALADO_COLUMNAS 4     // Los tres motores y el AVL con el otro cerrojo
+#define CERROJO_TOMAS 1000000
+const char* nombresCerrojo[] = {"mutex del sistema", "giro y espera"};
+
+/// pre: modo es CERROJO_SISTEMA o CERROJO_GIRO
+///post: Retorna los nanosegundos que cuesta tomar y soltar el cerrojo sin contencion
+double costoCerrojo(int modo) {
+    struct CerrojoAVL cerrojo;
+    LARGE_INTEGER frecuencia, t0, t1;
+
+    cerrojoInicializar(&cerrojo);
+    cerrojoElegirModo(&cerrojo, modo);
+    QueryPerformanceFrequency(&frecuencia);
+    QueryPerformanceCounter(&t0);
+    for (int i = 0; i < CERROJO_TOMAS; i++) {
+        cerrojoTomar(&cerrojo);
+        cerrojoSoltar(&cerrojo);
+    }
+    QueryPerformanceCounter(&t1);
+    cerrojoDestruir(&cerrojo);
+    return (double)(t1.QuadPart - t0.QuadPart) * 1e9 / frecuencia.QuadPart / CERROJO_TOMAS;
+}
+#else
+#define ESCALADO_COLUMNAS 3
+#endif
+
+/// pre: antes y despues: fotos de la categoria del motor al empezar la precarga y al terminar la medicion
+///post: Escribe en JSON lo que ocupa la estructura medida (diferencia entre las fotos) y la memoria residente
+void escribirMemoriaJSON(FILE* salida, struct MemoriaCategoria* antes, struct MemoriaCategoria* despues, int claves) {
+    struct MemoriaProceso proceso;
+    long long heap = despues->heap - antes->heap;
+    memoriaProceso(&proceso);
+    fprintf(salida, "{\"claves\": %d, \"pedidos\": %lld, \"heap\": %lld, \"picoHeap\": %lld, "
+                    "\"bytesPorClave\": %.2lf, \"residente\": %zu, \"picoResidente\": %zu}",
+            claves, despues->pedidos - antes->pedidos, heap, despues->pico - antes->heap,
+            claves > 0 ? (double)heap / claves : 0.0, proceso.residente, proceso.picoResidente);
+}
+
+/// pre: operaciones > 0 - rango > 1 - cerrojo es CERROJO_SISTEMA o CERROJO_GIRO (solo politica mutex)
+///post: Para cada motor y cada cantidad de hilos (1 a 64) precarga rango / 2 claves, reparte
+///      operaciones entre los hilos y muestra los millones de operaciones por segundo
+void benchmarkEscalado(int operaciones, int rango, int cerrojo) {
+    static const int hilosPorPaso[ESCALADO_PASOS] = {1, 2, 4, 8, 16, 32, 64};
+    static struct ArgsEscalado args[ESCALADO_HILOS_MAXIMO];
+    HANDLE hilos[ESCALADO_HILOS_MAXIMO];
+    double mops[ESCALADO_PASOS][ESCALADO_COLUMNAS];
+    double bytesPorClave[ESCALADO_COLUMNAS];    // Heap por clave con 1 hilo
+    LARGE_INTEGER frecuencia, t0, t1;
+
+    vaciarPapelera(0);      // La memoria de cada medicion es la diferencia de la categoria del motor
+    FILE* json = fopen(ARCHIVO_ESCALADO, "w");
+    if (json != NULL)
+        fprintf(json, "{\"operaciones\": %d, \"rango\": %d, \"mediciones\": [", operaciones, rango);
+
+    QueryPerformanceFrequency(&frecuencia);
+    for (int columna = 0; columna < ESCALADO_COLUMNAS; columna++) {
+        int motor = columna <= MOTOR_SKIPLIST ? columna : MOTOR_AVL;
+        for (int paso = 0; paso < ESCALADO_PASOS; paso++) {
+            struct ArbolAVL avl;
+            struct ArbolBMas bmas;
+            struct ListaSkl skl;
+            struct MemoriaCategoria antes, despues;
+            int n = hilosPorPaso[paso];
+            HANDLE largada = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+            memoriaLeer(memoriaMotor[motor], &antes);
+            memoriaReiniciarPico(memoriaMotor[motor]);
+
+            avlInicializar(&avl);
+            bmasInicializar(&bmas);
+            sklInicializar(&skl);
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+            cerrojoElegirModo(&avl.cerrojo, columna == MOTOR_SKIPLIST + 1 ? !cerrojo : cerrojo);
+            cerrojoElegirModo(&bmas.cerrojo, cerrojo);
+#else
+            (void)cerrojo;
+#endif
+            for (int k = 0; k < rango; k += 2) {    // Mitad de las claves: las busquedas aciertan la mitad
+                if (motor == MOTOR_AVL) avlInsertar(&avl, k);
+                else if (motor == MOTOR_BMAS) bmasInsertar(&bmas, k);
+                else sklInsertar(&skl, k);
+            }
+
+            for (int i = 0; i < n; i++) {
+                args[i].motor = motor;
+                args[i].avl = &avl;
+                args[i].bmas = &bmas;
+                args[i].skl = &skl;
+                args[i].operaciones = operaciones / n + (i < operaciones % n ? 1 : 0);
+                args[i].rango = rango;
+                args[i].semilla = (unsigned int)(i + 1) * 2654435761u;
+                args[i].largada = largada;
+                hilos[i] = CreateThread(NULL, 0, threadEscalado, &args[i], 0, NULL);
+            }
+
+            avlContadoresReiniciar();     // Los contadores de la precarga no cuentan
+            QueryPerformanceCounter(&t0);
+            SetEvent(largada);
+            WaitForMultipleObjects(n, hilos, TRUE, INFINITE);   // n <= MAXIMUM_WAIT_OBJECTS
+            QueryPerformanceCounter(&t1);
+
+            double segundos = (double)(t1.QuadPart - t0.QuadPart) / frecuencia.QuadPart;
+            mops[paso][columna] = segundos > 0 ? operaciones / segundos / 1e6 : 0;
+
+            size_t estimada;
+            int nivelMaximo;
+            int claves = motor == MOTOR_AVL ? contarNodos(avl.raiz)
+                       : motor == MOTOR_BMAS ? bmasContarClaves(bmas.raiz) : sklContar(&skl, &estimada, &nivelMaximo);
+            memoriaLeer(memoriaMotor[motor], &despues);
+            if (paso == 0)
+                bytesPorClave[columna] = claves > 0 ? (double)(despues.heap - antes.heap) / claves : 0;
+
+            if (json != NULL) {
+                fprintf(json, "%s\n  {\"motor\": \"%s\", ", (columna == 0 && paso == 0) ? "" : ",", nombresMotor[motor]);
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+                if (motor != MOTOR_SKIPLIST)
+                    fprintf(json, "\"cerrojo\": \"%s\", ",
+                            nombresCerrojo[columna == MOTOR_SKIPLIST + 1 ? !cerrojo : cerrojo]);
+#endif
+                fprintf(json, "\"hilos\": %d, \"segundos\": %.6lf, \"mops\": %.4lf, \"contadores\": ",
+                        n, segundos, mops[paso][columna]);
+                escribirContadoresJSON(json);
+                fprintf(json, ", \"memoria\": ");
+                escribirMemoriaJSON(json, &antes, &despues, claves);
+                fprintf(json, "}");
+            }
+
+            for (int i = 0; i < n; i++)
+                CloseHandle(hilos[i]);
+            CloseHandle(largada);
+            avlDestruir(&avl);
+            bmasDestruir(&bmas);
+            sklDestruir(&skl);
+        }
+    }
+
+    if (json != NULL) {
+        fprintf(json, "\n]}\n");
+        fclose(json);
+    }
+
+    printf("\n======== Escalado por hilos (%d operaciones, claves en [0, %d)) ========\n", operaciones, rango);
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    printf("Cerrojo de AVL y B+: %s - ultima columna: AVL con %s\n", nombresCerrojo[cerrojo], nombresCerrojo[!cerrojo]);
+    printf("Tomar y soltar sin contencion: %s %.1lf ns - %s %.1lf ns\n",
+           nombresCerrojo[CERROJO_SISTEMA], costoCerrojo(CERROJO_SISTEMA), nombresCerrojo[CERROJO_GIRO], costoCerrojo(CERROJO_GIRO));
+    printf("| %-6s | %-12s | %-12s | %-14s | %-14s |\n", "Hilos", "AVL (Mops/s)", "B+ (Mops/s)", "Skip (Mops/s)", "AVL otro cerr.");
+    printf("|--------|--------------|--------------|----------------|----------------|\n");
+    for (int paso = 0; paso < ESCALADO_PASOS; paso++)
+        printf("| %-6d | %-12.3lf | %-12.3lf | %-14.3lf | %-14.3lf |\n", hilosPorPaso[paso],
+               mops[paso][MOTOR_AVL], mops[paso][MOTOR_BMAS], mops[paso][MOTOR_SKIPLIST], mops[paso][MOTOR_SKIPLIST + 1]);
+#else
+    printf("| %-6s | %-12s | %-12s | %-14s |\n", "Hilos", "AVL (Mops/s)", "B+ (Mops/s)", "Skip (Mops/s)");
+    printf("|--------|--------------|--------------|----------------|\n");
+    for (int paso = 0; paso < ESCALADO_PASOS; paso++)
+        printf("| %-6d | %-12.3lf | %-12.3lf | %-14.3lf |\n", hilosPorPaso[paso],
+               mops[paso][MOTOR_AVL], mops[paso][MOTOR_BMAS], mops[paso][MOTOR_SKIPLIST]);
+#endif
+    printf("Bytes en el heap por clave (1 hilo): AVL %.1lf - B+ %.1lf - skip list %.1lf\n",
+           bytesPorClave[MOTOR_AVL], bytesPorClave[MOTOR_BMAS], bytesPorClave[MOTOR_SKIPLIST]);
+    if (json != NULL)
+        printf("Mediciones, contadores y memoria guardados en '%s'.\n", ARCHIVO_ESCALADO);
+}
+
+// ---------------------------------- Grabacion y reproduccion de trazas ----------------------------------
+// La grabacion guarda primero una foto ordenada de las claves del motor activo y despues las operaciones
+// (ver "Traza de operaciones"). Con trafico en curso la foto puede no incluir alguna operacion que entro
+// justo antes de empezar. La reproduccion arma un motor local (AVL, B+ o skip list, y con la politica
+// mutex el cerrojo elegido), carga la foto y reparte los registros entre los hilos segun el hilo que
+// los grabo: cada hilo grabado cae entero en un hilo de reproduccion y conserva su orden. Se reproduce
+// lo mas rapido posible o respetando los tiempos grabados.
+
+struct ArgsReproduccion {
+    int motor;
+    struct ArbolAVL* avl;
+    struct ArbolBMas* bmas;
+    struct ListaSkl* skl;
+    struct RegistroTraza* registros;    // Los de este hilo, en el orden grabado
+    int cantidad;
+    int ritmoOriginal;                  // 1: espera el tiempo grabado de cada operacion
+    LARGE_INTEGER partida;              // Instante que corresponde al microsegundo 0 de la traza
+    LONGLONG frecuencia;
+    HANDLE largada;
+    int aciertos;                       // Operaciones que retornaron 1
+    double retrasoMaximo;               // Ritmo original: milisegundos maximos de atraso respecto de lo grabado
+};
+
+/// pre: capacidad > 0 - no se esta grabando
+///post: Guarda la foto de claves del motor activo y empieza a anotar hasta capacidad operaciones.
+///      Retorna 1 si pudo reservar el buffer
+int iniciarGrabacion(const char* ruta, int capacidad) {
+    struct RegistroTraza* registros = (struct RegistroTraza*)malloc((size_t)capacidad * sizeof(struct RegistroTraza));
+    int* claves;
+    int cantidad;
+
+    if (registros == NULL)
+        return 0;
+    captura.registros = registros;
+    captura.capacidad = capacidad;
+    captura.cantidad = 0;
+    captura.vencidas = 0;
+    captura.hilos = 0;
+    captura.generacion = (captura.generacion + 1) & 0x7FFF;     // Nunca 0: es lo que devuelve un hilo sin marca
+    if (captura.generacion == 0)
+        captura.generacion = 1;
+    strncpy(captura.ruta, ruta, MAX_PATH - 1);
+    captura.ruta[MAX_PATH - 1] = '\0';
+    QueryPerformanceFrequency(&captura.frecuencia);
+
+    // La grabacion empieza con el motor tomado: lo que se anote despues no esta en la foto
+    if (config.motor == MOTOR_AVL) {
+        avlBloquearEscritura(&arbol);
+        struct Node* raiz = config.versionesPersistentes ? versionActual->raiz : arbol.raiz;
+        claves = (int*)malloc((contarNodos(raiz) + 1) * sizeof(int));
+        cantidad = recolectarClaves(raiz, claves, 0);   // Los borrados logicos no estan
+        QueryPerformanceCounter(&captura.inicio);
+        InterlockedExchange(&captura.activa, 1);
+        avlLiberarEscritura(&arbol);
+    } else if (config.motor == MOTOR_BMAS) {
+        bmasBloquearLectura(&arbolBMas);
+        cantidad = bmasContarClaves(arbolBMas.raiz);
+        claves = (int*)malloc((cantidad + 1) * sizeof(int));
+        bmasRango(arbolBMas.raiz, INT_MIN, INT_MAX, claves, cantidad);
+        QueryPerformanceCounter(&captura.inicio);
+        InterlockedExchange(&captura.activa, 1);
+        bmasLiberarLectura(&arbolBMas);
+    } else {
+        int capacidadClaves = sklContar(&listaSkl, NULL, NULL) + 1024;  // Sin bloqueo: margen por si crece
+        claves = (int*)malloc(capacidadClaves * sizeof(int));
+        cantidad = sklRango(&listaSkl, INT_MIN, INT_MAX, claves, capacidadClaves);
+        QueryPerformanceCounter(&captura.inicio);
+        InterlockedExchange(&captura.activa, 1);
+    }
+    captura.claves = claves;
+    captura.cantidadClaves = cantidad;
+    return 1;
+}
+
+/// pre: Se esta grabando
+///post: Deja de anotar, espera a quienes estaban anotando y escribe la traza en captura.ruta.
+///      Retorna 1 si pudo escribir el archivo
+int detenerGrabacion() {
+    struct CabeceraTraza cabecera = {{'A', 'V', 'L', 'T'}, VERSION_TRAZA};
+    LARGE_INTEGER fin;
+    int escrito = 0;
+
+    AcquireSRWLockExclusive(&captura.lock);     // Cuando se obtiene nadie esta dentro de trazaAnotarGrabando
+    captura.activa = 0;
+    ReleaseSRWLockExclusive(&captura.lock);
+    QueryPerformanceCounter(&fin);
+
+    cabecera.claves = captura.cantidadClaves;
+    cabecera.registros = captura.cantidad < captura.capacidad ? captura.cantidad : captura.capacidad;
+    cabecera.hilos = captura.hilos;
+    cabecera.perdidos = captura.cantidad - cabecera.registros + captura.vencidas;
+
+    FILE* archivo = fopen(captura.ruta, "wb");
+    if (archivo != NULL) {
+        escrito = fwrite(&cabecera, sizeof(cabecera), 1, archivo) == 1
+               && fwrite(captura.claves, sizeof(int), cabecera.claves, archivo) == (size_t)cabecera.claves
+               && fwrite(captura.registros, sizeof(struct RegistroTraza), cabecera.registros, archivo) == (size_t)cabecera.registros;
+        escrito = (fclose(archivo) == 0) && escrito;
+    }
+
+    printf("Traza: %d operaciones de %d hilos en %.3lf segundos, %d claves iniciales",
+           cabecera.registros, cabecera.hilos,
+           (double)(fin.QuadPart - captura.inicio.QuadPart) / captura.frecuencia.QuadPart, cabecera.claves);
+    if (captura.cantidad > cabecera.registros)
+        printf(" - %ld operaciones no entraron en el buffer", captura.cantidad - cabecera.registros);
+    if (captura.vencidas > 0)
+        printf(" - %ld operaciones despues de los 71 minutos que admite un registro", captura.vencidas);
+    printf("\n");
+
+    free(captura.registros);
+    free(captura.claves);
+    captura.registros = NULL;
+    captura.claves = NULL;
+    return escrito;
+}
+
+/// pre: objetivo es una lectura de QueryPerformanceCounter
+///post: Retorna cuando el contador llega a objetivo. Duerme mientras falte mas de 2 ms y despues gira
+void esperarHasta(LONGLONG objetivo, LONGLONG frecuencia) {
+    LARGE_INTEGER ahora;
+
+    QueryPerformanceCounter(&ahora);
+    while (ahora.QuadPart < objetivo) {
+        LONGLONG faltaMs = (objetivo - ahora.QuadPart) * 1000 / frecuencia;
+        if (faltaMs > 2)
+            Sleep((DWORD)(faltaMs - 1));
+        else
+            YieldProcessor();
+        QueryPerformanceCounter(&ahora);
+    }
+}
+
+DWORD WINAPI threadReproduccion(LPVOID arg) {
+    struct ArgsReproduccion* a = (struct ArgsReproduccion*)arg;
+    LARGE_INTEGER ahora;
+
+    WaitForSingleObject(a->largada, INFINITE);
+    for (int i = 0; i < a->cantidad; i++) {
+        struct RegistroTraza* r = &a->registros[i];
+        if (a->ritmoOriginal) {
+            LONGLONG objetivo = a->partida.QuadPart + (LONGLONG)r->microsegundos * a->frecuencia / 1000000;
+            QueryPerformanceCounter(&ahora);
+            if (ahora.QuadPart < objetivo) {
+                esperarHasta(objetivo, a->frecuencia);
+            } else {
+                double retraso = (double)(ahora.QuadPart - objetivo) * 1000.0 / a->frecuencia;
+                if (retraso > a->retrasoMaximo)
+                    a->retrasoMaximo = retraso;
+            }
+        }
+        a->aciertos += operarMotorLocal(a->motor, a->avl, a->bmas, a->skl, r->operacion, r->key);
+    }
+    return 0;
+}
+
+/// pre: 1 <= hilos <= ESCALADO_HILOS_MAXIMO - motor es un MotorArbol - cerrojo es CERROJO_* (solo politica mutex)
+///post: Reproduce la traza del archivo sobre un motor local cargado con la foto inicial y muestra el tiempo,
+///      las operaciones por segundo y, con el ritmo original, el mayor atraso. Retorna 0 si el archivo no es valido
+int reproducirTraza(const char* ruta, int motor, int hilos, int ritmoOriginal, int cerrojo) {
+    static struct ArgsReproduccion args[ESCALADO_HILOS_MAXIMO];
+    HANDLE manejadores[ESCALADO_HILOS_MAXIMO];
+    struct CabeceraTraza cabecera;
+    struct ArbolAVL avl;
+    struct ArbolBMas bmas;
+    struct ListaSkl skl;
+    int porTipo[3] = {0, 0, 0};
+    int aciertos = 0, insertado;
+    double retrasoMaximo = 0;
+    LARGE_INTEGER frecuencia, fin;
+
+    FILE* archivo = fopen(ruta, "rb");
+    if (archivo == NULL)
+        return 0;
+    if (fread(&cabecera, sizeof(cabecera), 1, archivo) != 1 || memcmp(cabecera.magia, "AVLT", 4) != 0
+        || cabecera.version != VERSION_TRAZA || cabecera.claves < 0 || cabecera.registros < 0) {
+        fclose(archivo);
+        return 0;
+    }
+    int* claves = (int*)malloc(((size_t)cabecera.claves + 1) * sizeof(int));
+    struct RegistroTraza* registros = (struct RegistroTraza*)malloc(((size_t)cabecera.registros + 1) * sizeof(struct RegistroTraza));
+    struct RegistroTraza* repartidos = (struct RegistroTraza*)malloc(((size_t)cabecera.registros + 1) * sizeof(struct RegistroTraza));
+    int valido = claves != NULL && registros != NULL && repartidos != NULL
+              && fread(claves, sizeof(int), cabecera.claves, archivo) == (size_t)cabecera.claves
+              && fread(registros, sizeof(struct RegistroTraza), cabecera.registros, archivo) == (size_t)cabecera.registros;
+    fclose(archivo);
+    for (int i = 1; valido && i < cabecera.claves; i++)
+        valido = claves[i - 1] < claves[i];     // construirOrdenado necesita claves crecientes y sin repetir
+    for (int i = 0; valido && i < cabecera.registros; i++)
+        valido = registros[i].operacion <= TRAZA_ELIMINAR;
+    if (!valido) {
+        free(claves);
+        free(registros);
+        free(repartidos);
+        return 0;
+    }
+
+    // Reparto estable por hilo grabado: cuenta por hilo, posiciones de inicio y copia en orden
+    int inicio[ESCALADO_HILOS_MAXIMO + 1] = {0};
+    for (int i = 0; i < cabecera.registros; i++) {
+        inicio[registros[i].hilo % hilos + 1]++;
+        porTipo[registros[i].operacion]++;
+    }
+    for (int h = 0; h < hilos; h++)
+        inicio[h + 1] += inicio[h];
+    for (int h = 0; h < hilos; h++)
+        args[h].cantidad = 0;
+    for (int i = 0; i < cabecera.registros; i++) {
+        int h = registros[i].hilo % hilos;
+        repartidos[inicio[h] + args[h].cantidad++] = registros[i];
+    }
+    free(registros);
+
+    // Motor local con la foto inicial (las claves de la foto estan ordenadas)
+    avlInicializar(&avl);
+    bmasInicializar(&bmas);
+    sklInicializar(&skl);
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoElegirModo(&avl.cerrojo, cerrojo);
+    cerrojoElegirModo(&bmas.cerrojo, cerrojo);
+#else
+    (void)cerrojo;
+#endif
+    if (motor == MOTOR_AVL) {
+        avl.raiz = construirOrdenado(claves, cabecera.claves);
+    } else {
+        for (int i = 0; i < cabecera.claves; i++) {
+            if (motor == MOTOR_BMAS)
+                bmas.raiz = bmasInsert(bmas.raiz, claves[i], &insertado);
+            else
+                sklInsertar(&skl, claves[i]);
+        }
+    }
+    free(claves);
+
+    QueryPerformanceFrequency(&frecuencia);
+    HANDLE largada = CreateEvent(NULL, TRUE, FALSE, NULL);
+    for (int h = 0; h < hilos; h++) {
+        args[h].motor = motor;
+        args[h].avl = &avl;
+        args[h].bmas = &bmas;
+        args[h].skl = &skl;
+        args[h].registros = repartidos + inicio[h];
+        args[h].ritmoOriginal = ritmoOriginal;
+        args[h].frecuencia = frecuencia.QuadPart;
+        args[h].largada = largada;
+        args[h].aciertos = 0;
+        args[h].retrasoMaximo = 0;
+        manejadores[h] = CreateThread(NULL, 0, threadReproduccion, &args[h], 0, NULL);
+    }
+
+    QueryPerformanceCounter(&args[0].partida);
+    for (int h = 1; h < hilos; h++)
+        args[h].partida = args[0].partida;
+    SetEvent(largada);
+    WaitForMultipleObjects(hilos, manejadores, TRUE, INFINITE);
+    QueryPerformanceCounter(&fin);
+
+    for (int h = 0; h < hilos; h++) {
+        aciertos += args[h].aciertos;
+        if (args[h].retrasoMaximo > retrasoMaximo)
+            retrasoMaximo = args[h].retrasoMaximo;
+        CloseHandle(manejadores[h]);
+    }
+    CloseHandle(largada);
+    avlDestruir(&avl);
+    bmasDestruir(&bmas);
+    sklDestruir(&skl);
+    free(repartidos);
+
+    double segundos = (double)(fin.QuadPart - args[0].partida.QuadPart) / frecuencia.QuadPart;
+    printf("\n======== Reproduccion de %s ========\n", ruta);
+    printf("Motor: %s - hilos: %d (grabados: %d) - ritmo: %s\n", nombresMotor[motor], hilos, cabecera.hilos,
+           ritmoOriginal ? "original" : "lo mas rapido posible");
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    if (motor != MOTOR_SKIPLIST)
+        printf("Cerrojo: %s\n", nombresCerrojo[cerrojo]);
+#endif
+    printf("Claves iniciales: %d - operaciones: %d (%d %s, %d %s, %d %s)\n", cabecera.claves, cabecera.registros,
+           porTipo[TRAZA_INSERTAR], nombresOperacionTraza[TRAZA_INSERTAR], porTipo[TRAZA_BUSCAR],
+           nombresOperacionTraza[TRAZA_BUSCAR], porTipo[TRAZA_ELIMINAR], nombresOperacionTraza[TRAZA_ELIMINAR]);
+    printf("Operaciones que retornaron 1: %d\n", aciertos);
+    printf("Tiempo: %.3lf ms - %.3lf Mops/s\n", segundos * 1000.0, segundos > 0 ? cabecera.registros / segundos / 1e6 : 0);
+    if (ritmoOriginal)
+        printf("Mayor atraso respecto de lo grabado: %.3lf ms\n", retrasoMaximo);
+    return 1;
+}
+
 
+// ---------------------------------- Ingesta de archivos ----------------------------------
+// Carga claves desde archivos grandes sin scanf. El archivo se mapea en memoria y se parte en un
+// trozo por hilo, con cada corte corrido hasta el final de un registro. Cada hilo convierte su trozo
+// a enteros, los ordena y les quita los repetidos; despues los trozos se mezclan de a pares en
+// paralelo y el resultado se carga de una vez en el motor activo (en el AVL se arma el arbol
+// balanceado directo desde el arreglo ordenado, sin rotaciones).
+//
+// Formatos: texto con enteros decimales separados por cualquier caracter que no sea digito ni '-'
+// (una clave por linea, CSV, ...), o binario con enteros de 32 bits little-endian seguidos.
+// En un ejecutable de 32 bits el archivo tiene que entrar en el espacio de direcciones.
 
-// ---------------------------------- AVL Global ----------------------------------
+#define MAX_HILOS_INGESTA 64
+#define UNOS_BYTES 0x0101010101010101ULL
 
-// Nodo raiz del arbol
-struct Node* root = NULL;
+enum FormatoIngesta {
+    INGESTA_TEXTO,
+    INGESTA_BINARIO
+};
 
-// ---------------------------------- Mutex para sincronizacin ----------------------------------
-/// Mutex para evitar condiciones de carrera al insertar desde mltiples hilos
-HANDLE tree_mutex;
+// Trozo de archivo de un hilo. Tambien sirve como arreglo ordenado durante la mezcla
+struct TrozoIngesta {
+    const unsigned char* inicio;
+    const unsigned char* fin;
+    const unsigned char* finMapeo;  // Fin del archivo: hasta aca se puede leer de a 8 bytes
+    int formato;
+    int* claves;                    // Al terminar: claves del trozo ordenadas y sin repetidos
+    size_t cantidad;
+    size_t capacidad;
+    size_t leidos;                  // Claves del trozo antes de quitar repetidos
+    size_t descartados;             // Numeros que no entran en un int
+};
 
-// ---------------------------------- Funciones del AVL ----------------------------------
-/// pre: Requiere un nodo en argumento
-///post: Retorna la altura del nodo - 0 si es NULL
-int getHeight(struct Node* n) {
-    return (n == NULL) ? 0 : n->height;
-}
+// Mezcla de dos arreglos ordenados en un hilo
+struct ArgsMezcla {
+    struct TrozoIngesta* a;
+    struct TrozoIngesta* b;
+    struct TrozoIngesta resultado;
+};
 
-// Cuenta los nodos del rbol (uso de memoria)
-int contarNodos(struct Node * nodo) {
-    if (nodo == NULL) return 0;
-    return 1 + contarNodos(nodo->left) + contarNodos(nodo->right);
+int compararEnteros(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
 }
 
-// Calcula la altura real del rbol
-/// pre: requiere un nodo, que es un puntero a una struct Node
-///post: retorna la altura del arbol, siendo este un valor entero
-int calcularAltura(struct Node * nodo) {
-    if (nodo == NULL) return 0;
-    int altIzq = calcularAltura(nodo->left);
-    int altDer = calcularAltura(nodo->right);
-    return 1 + (altIzq > altDer ? altIzq : altDer);
+/// pre: v: 8 bytes del archivo, el primero en el byte bajo
+///post: Retorna cuantos bytes del principio son digitos ASCII (0 a 8), sin una rama por byte
+static inline int digitosIniciales(unsigned long long v) {
+    unsigned long long x = v ^ (0x30 * UNOS_BYTES);    // Los digitos quedan en 0..9 y el resto fuera
+    // Bit alto de cada byte en 1 si el byte es mayor que 9. El acarreo de un byte que no es digito
+    // solo puede ensuciar los siguientes, y de ellos no se usa ninguno
+    unsigned long long noDigitos = (x | (x + 0x76 * UNOS_BYTES)) & (0x80 * UNOS_BYTES);
+    return noDigitos ? __builtin_ctzll(noDigitos) >> 3 : 8;
 }
 
-// Buscar un valor en el rbol y devolver su profundidad
-/// pre: requiere un nodo, que es un puntero a una struct Node - valor: dato a buscar - nivel: nivel del arbol
-int buscarConProfundidad(struct Node* raiz, int valor, int nivel) {
-    if (raiz == NULL) {
-        return -1;  // No encontrado
-    }
-    if (valor == raiz->key) {
-        return nivel;  // Encontrado en este nivel
-    } else if (valor < raiz->key) {
-        return buscarConProfundidad(raiz->left, valor, nivel + 1);
-    } else {
-        return buscarConProfundidad(raiz->right, valor, nivel + 1);
-    }
+/// pre: x: 8 valores de digito (0..9), el mas significativo en el byte bajo
+///post: Retorna el numero de 8 cifras con tres multiplicaciones en lugar de ocho
+static inline unsigned int convertirOchoDigitos(unsigned long long x) {
+    x = (x * 2561) >> 8;                                            // Pares de digitos: 10 * a + b
+    x = ((x & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;              // Grupos de 4: 100 * ab + cd
+    return (unsigned int)(((x & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);  // 10000 * abcd + efgh
 }
 
-/// pre: a y b son valores enteros
-///post: Compara a y b, retornando el valor mas grande
-int mayor(int a, int b) {
-    return (a > b) ? a : b;
+static int esParteDeNumero(unsigned char c) {
+    return c == '-' || (unsigned int)(c - '0') <= 9;
 }
 
-/// pre: key es el dato, siendo un valor entero
-///post: Crea e inicialia un nuevo nodo con el valor del dato key ingresado x parametro
-struct Node* createNode(int key) {
-    struct Node* node = (struct Node*)malloc(sizeof(struct Node));
-    node->key = key;
-    node->left = NULL;
-    node->right = NULL;
-    node->height = 1;
-    return node;
+static void agregarClaveTrozo(struct TrozoIngesta* t, int key) {
+    if (t->cantidad == t->capacidad) {
+        t->capacidad = t->capacidad * 2 + 16;
+        t->claves = (int*)realloc(t->claves, t->capacidad * sizeof(int));
+    }
+    t->claves[t->cantidad++] = key;
 }
 
-/// pre: Requiere un Nodo como parametro
-///post: Calcula el balance del nodo para saber si hay que rotar
-///         como la diferencia de altura entre sus subarboles izquierdo y derecho - Retorna 0 si es NULL
-int getBalanceFactor(struct Node* n) {
-    if (n == NULL)
-        return 0;
-    return getHeight(n->left) - getHeight(n->right);
-}
+/// pre: t->inicio y t->fin no cortan ningun numero
+///post: Agrega a t->claves los enteros del texto. Los digitos se leen de a 8 bytes salvo al final del archivo
+void parsearTexto(struct TrozoIngesta* t) {
+    static const unsigned long long potencias[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    const unsigned char* p = t->inicio;
 
-/// pre: Requiere  un nodo como argumento
-///post: Realiza una rotacion simple a la derecha
-///     para mantener el equilibrio del arbo tras cada insercion si esta desbalanceado por izquierda
-struct Node* rightRotate(struct Node* y) {
-    struct Node* x = y->left;
-    struct Node* T2 = x->right;
+    t->capacidad = (size_t)(t->fin - t->inicio) / 8 + 16;  // Una clave cada 8 bytes; si no alcanza se agranda
+    t->claves = (int*)malloc(t->capacidad * sizeof(int));
 
-    x->right = y;
-    y->left = T2;
+    while (p < t->fin) {
+        if (!esParteDeNumero(*p)) {     // Separadores
+            p++;
+            continue;
+        }
+        int negativo = *p == '-';
+        p += negativo;
+
+        unsigned long long valor = 0;
+        int cifras = 0;
+        for (;;) {
+            if (p + 8 > t->finMapeo) {  // Ultimos bytes del archivo: de a uno
+                while (p < t->finMapeo && (unsigned int)(*p - '0') <= 9) {
+                    valor = valor * 10 + (*p - '0');
+                    cifras++;
+                    p++;
+                }
+                break;
+            }
+            unsigned long long v;
+            memcpy(&v, p, 8);
+            int n = digitosIniciales(v);
+            if (n > 0)  // Los n digitos van a los bytes altos: adelante quedan ceros a la izquierda
+                valor = valor * potencias[n] + convertirOchoDigitos((v ^ (0x30 * UNOS_BYTES)) << (8 * (8 - n)));
+            cifras += n;
+            p += n;
+            if (n < 8)
+                break;
+        }
 
-    y->height = mayor(getHeight(y->left), getHeight(y->right)) + 1;
-    x->height = mayor(getHeight(x->left), getHeight(x->right)) + 1;
+        if (cifras == 0)                // Un '-' suelto
+            continue;
+        long long numero = negativo ? -(long long)valor : (long long)valor;
+        if (cifras > 10 || numero < INT_MIN || numero > INT_MAX)
+            t->descartados++;
+        else
+            agregarClaveTrozo(t, (int)numero);
+    }
+}
 
-    return x;
+/// pre: t->inicio y t->fin alineados a 4 bytes respecto del inicio del archivo
+///post: Copia los enteros de 32 bits del trozo en t->claves
+void parsearBinario(struct TrozoIngesta* t) {
+    t->cantidad = t->capacidad = (size_t)(t->fin - t->inicio) / sizeof(int);
+    t->claves = (int*)malloc((t->capacidad + 1) * sizeof(int));
+    memcpy(t->claves, t->inicio, t->cantidad * sizeof(int));
 }
 
-/// pre: Requiere  un nodo como argumento
-///post: Realiza una rotacion simple a la izquierda
-///     para mantener el equilibrio del arbo tras cada insercion si esta desbalanceado por derecha
-struct Node* leftRotate(struct Node* x) {
-    struct Node* y = x->right;
-    struct Node* T2 = y->left;
+/// pre: t->claves ordenado
+///post: Deja una sola copia de cada clave
+void quitarRepetidos(struct TrozoIngesta* t) {
+    size_t unicos = 0;
+    for (size_t i = 0; i < t->cantidad; i++)
+        if (unicos == 0 || t->claves[i] != t->claves[unicos - 1])
+            t->claves[unicos++] = t->claves[i];
+    t->cantidad = unicos;
+}
 
-    y->left = x;
-    x->right = T2;
+DWORD WINAPI threadIngesta(LPVOID args) {
+    struct TrozoIngesta* t = (struct TrozoIngesta*)args;
+    if (t->formato == INGESTA_TEXTO)
+        parsearTexto(t);
+    else
+        parsearBinario(t);
+    t->leidos = t->cantidad;
+    qsort(t->claves, t->cantidad, sizeof(int), compararEnteros);
+    quitarRepetidos(t);
+    return 0;
+}
 
-    x->height = mayor(getHeight(x->left), getHeight(x->right)) + 1;
-    y->height = mayor(getHeight(y->left), getHeight(y->right)) + 1;
+/// pre: a y b ordenados y sin repetidos
+///post: Deja en resultado la union ordenada y sin repetidos de a y b
+void mezclarOrdenados(struct TrozoIngesta* a, struct TrozoIngesta* b, struct TrozoIngesta* resultado) {
+    size_t i = 0, j = 0, k = 0;
+    int* destino = (int*)malloc((a->cantidad + b->cantidad + 1) * sizeof(int));
+
+    while (i < a->cantidad && j < b->cantidad) {
+        int x = a->claves[i], y = b->claves[j];
+        destino[k++] = x < y ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    while (i < a->cantidad)
+        destino[k++] = a->claves[i++];
+    while (j < b->cantidad)
+        destino[k++] = b->claves[j++];
 
-    return y;
+    resultado->claves = destino;
+    resultado->cantidad = resultado->capacidad = k;
 }
 
-/// pre: Requiere un puntero al nodo y el dato siendo un entero que se quiera insertar en el AVL
-///post: funcion recursiva, inserta un dato al arbol.
-///     Si el nodo actual es NULL, crea uno.
-///     Si el valor existe, no se inserta por no admitir duplicados
-///     Al insertar el dato, se actualiza la altura del nodo y se calcula su balance.
-///     Si esta desquilibrado, se ejecutan 1 de las 4 posibles rotaciones necesarias.
-struct Node* insert(struct Node* node, int key) {
-
-    // Realiza la insercion del arbol de busqueda binario
-    if (node == NULL)
-        return createNode(key); // Caso base: nodo vaco, se crea uno nuevo
+DWORD WINAPI threadMezcla(LPVOID args) {
+    struct ArgsMezcla* m = (struct ArgsMezcla*)args;
+    mezclarOrdenados(m->a, m->b, &m->resultado);
+    free(m->a->claves);
+    free(m->b->claves);
+    return 0;
+}
 
-    if (key < node->key)
-        node->left = insert(node->left, key);
-    else if (key > node->key)
-        node->right = insert(node->right, key);
-    else    // No se permiten datos duplicados
-        return node; // No se permiten duplicados
+/// pre: trozos[0..cantidad) ordenados y sin repetidos
+///post: Los mezcla de a pares, cada par en un hilo, hasta que queda uno solo en trozos[0]
+void mezclarTrozos(struct TrozoIngesta* trozos, int cantidad) {
+    HANDLE hilos[MAX_HILOS_INGESTA / 2];
+    struct ArgsMezcla mezclas[MAX_HILOS_INGESTA / 2];
+
+    while (cantidad > 1) {
+        int pares = cantidad / 2;
+        for (int i = 0; i < pares; i++) {
+            mezclas[i].a = &trozos[2 * i];
+            mezclas[i].b = &trozos[2 * i + 1];
+            hilos[i] = CreateThread(NULL, 0, threadMezcla, &mezclas[i], 0, NULL);
+        }
+        for (int i = 0; i < pares; i++) {
+            WaitForSingleObject(hilos[i], INFINITE);
+            CloseHandle(hilos[i]);
+            trozos[i].claves = mezclas[i].resultado.claves;
+            trozos[i].cantidad = mezclas[i].resultado.cantidad;
+        }
+        if (cantidad % 2 == 1) {        // El impar pasa sin mezclar a la ronda siguiente
+            trozos[pares].claves = trozos[cantidad - 1].claves;
+            trozos[pares].cantidad = trozos[cantidad - 1].cantidad;
+        }
+        cantidad = pares + cantidad % 2;
+    }
+}
 
-    // Actualiza altura del nodo padre
-    node->height = 1 + mayor(getHeight(node->left), getHeight(node->right));
+/// pre: claves ordenadas y sin repetidos
+///post: Las agrega al motor activo y retorna cuantas no estaban. En el AVL une las claves actuales
+///      con las nuevas y arma el arbol balanceado de una vez (tambien como nueva version persistente)
+size_t cargarClavesOrdenadas(int* claves, size_t cantidad) {
+    size_t nuevas = 0;
+    int insertado;
+
+    if (config.motor == MOTOR_SKIPLIST) {
+        for (size_t i = 0; i < cantidad; i++)
+            nuevas += sklInsertar(&listaSkl, claves[i]);
+        return nuevas;
+    }
 
-    // Obtiene el factor de equilibrio del nodo padre para corroborar que no se haya producido un desequilibrio
-    int balance = getBalanceFactor(node);
+    if (config.motor == MOTOR_BMAS) {
+        bmasBloquearEscritura(&arbolBMas);
+        for (size_t i = 0; i < cantidad; i++) {
+            arbolBMas.raiz = bmasInsert(arbolBMas.raiz, claves[i], &insertado);
+            nuevas += insertado;
+        }
+        bmasLiberarEscritura(&arbolBMas);
+        return nuevas;
+    }
 
-    // Existen 4 casos si el nodo se encuentra desquilibrado:
+    avlBloquearEscritura(&arbol);
+    procesarPendientes(CAPACIDAD_PENDIENTES);   // Con balanceo relajado no debe quedar nada pendiente
+    struct Node* raiz = config.versionesPersistentes ? versionActual->raiz : arbol.raiz;
+    struct TrozoIngesta actuales = {0}, ingresadas = {0}, todas;
+
+    actuales.claves = (int*)malloc((contarNodos(raiz) + 1) * sizeof(int));
+    actuales.cantidad = recolectarClaves(raiz, actuales.claves, 0);    // Los borrados logicos se descartan
+    ingresadas.claves = claves;
+    ingresadas.cantidad = cantidad;
+    mezclarOrdenados(&actuales, &ingresadas, &todas);
+    nuevas = todas.cantidad - actuales.cantidad;
+
+    if (todas.cantidad > INT_MAX) {
+        printf("Demasiadas claves para el arbol, no se carga nada.\n");
+        nuevas = 0;
+    } else if (nuevas > 0) {
+        struct Node* nueva = construirOrdenado(todas.claves, (int)todas.cantidad);
+        if (config.versionesPersistentes) {
+            publicarVersion(nueva);     // Los lectores de la version anterior la siguen viendo entera
+        } else {
+            liberarArbol(arbol.raiz);
+            arbol.raiz = nueva;
+            dedoReiniciar(&dedoArbol);
+        }
+        if (config.filtroBloom)
+            filtroReconstruir((int)todas.cantidad);
+    }
+    avlLiberarEscritura(&arbol);
 
-    // 1. Caso rotacion doble a la izquierda
-    if (balance > 1 && key < node->left->key)
-        return rightRotate(node);
+    free(actuales.claves);
+    free(todas.claves);
+    return nuevas;
+}
 
-    // 2. Caso rotacion doble a la derecha
-    if (balance < -1 && key > node->right->key)
-        return leftRotate(node);
+/// pre: ruta: archivo con claves en formato - hilos: entre 1 y MAX_HILOS_INGESTA
+///post: Mapea el archivo, lo convierte en paralelo y carga las claves en el motor activo.
+///      Muestra cuantas claves hubo y el tiempo y la velocidad de cada fase. Retorna 0 si no pudo abrirlo
+int ingerirArchivo(const char* ruta, int formato, int hilos) {
+    struct TrozoIngesta trozos[MAX_HILOS_INGESTA];
+    HANDLE handles[MAX_HILOS_INGESTA];
+    LARGE_INTEGER tamanio, frecuencia, t0, t1, t2, t3;
 
-    // 3. Caso rotacion izquierda-derecha
-    if (balance > 1 && key > node->left->key) {
-        node->left = leftRotate(node->left);
-        return rightRotate(node);
+    HANDLE archivo = CreateFileA(ruta, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (archivo == INVALID_HANDLE_VALUE)
+        return 0;
+    if (!GetFileSizeEx(archivo, &tamanio) || tamanio.QuadPart == 0) {
+        CloseHandle(archivo);
+        return 0;
+    }
+    HANDLE mapeo = CreateFileMappingA(archivo, NULL, PAGE_READONLY, 0, 0, NULL);
+    const unsigned char* datos = mapeo != NULL ? (const unsigned char*)MapViewOfFile(mapeo, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (datos == NULL) {
+        if (mapeo != NULL)
+            CloseHandle(mapeo);
+        CloseHandle(archivo);
+        return 0;
     }
 
-    // 4. Caso rotacion derecha-izquierda
-    if (balance < -1 && key < node->right->key) {
-        node->right = rightRotate(node->right);
-        return leftRotate(node);
+    size_t bytes = (size_t)tamanio.QuadPart;
+    if (hilos < 1)
+        hilos = 1;
+    if (hilos > MAX_HILOS_INGESTA)
+        hilos = MAX_HILOS_INGESTA;
+    if ((size_t)hilos > bytes)
+        hilos = (int)bytes;         // Archivos chicos: ningun trozo vacio al principio
+
+    QueryPerformanceFrequency(&frecuencia);
+    QueryPerformanceCounter(&t0);
+
+    // Cortes: en binario multiplos de 4; en texto se corren hasta no partir un numero al medio
+    size_t corte = 0;
+    for (int i = 0; i < hilos; i++) {
+        size_t siguiente = (i == hilos - 1) ? bytes : bytes / hilos * (i + 1);
+        if (formato == INGESTA_BINARIO) {
+            siguiente -= siguiente % sizeof(int);
+        } else {
+            while (siguiente > 0 && siguiente < bytes && esParteDeNumero(datos[siguiente]) && esParteDeNumero(datos[siguiente - 1]))
+                siguiente++;
+        }
+        if (siguiente < corte)
+            siguiente = corte;
+
+        memset(&trozos[i], 0, sizeof(struct TrozoIngesta));
+        trozos[i].inicio = datos + corte;
+        trozos[i].fin = datos + siguiente;
+        trozos[i].finMapeo = datos + bytes;
+        trozos[i].formato = formato;
+        handles[i] = CreateThread(NULL, 0, threadIngesta, &trozos[i], 0, NULL);
+        corte = siguiente;
     }
 
-    return node; // Nodo ya balanceado
+    size_t leidas = 0, descartadas = 0;
+    for (int i = 0; i < hilos; i++) {
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+        leidas += trozos[i].leidos;
+        descartadas += trozos[i].descartados;
+    }
+    QueryPerformanceCounter(&t1);
+
+    mezclarTrozos(trozos, hilos);
+    QueryPerformanceCounter(&t2);
+
+    size_t nuevas = cargarClavesOrdenadas(trozos[0].claves, trozos[0].cantidad);
+    QueryPerformanceCounter(&t3);
+
+    double msParseo = (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / frecuencia.QuadPart;
+    double msMezcla = (double)(t2.QuadPart - t1.QuadPart) * 1000.0 / frecuencia.QuadPart;
+    double msCarga = (double)(t3.QuadPart - t2.QuadPart) * 1000.0 / frecuencia.QuadPart;
+
+    printf("\n======== Ingesta de %s (%zu bytes, %d hilos, motor %s) ========\n",
+           ruta, bytes, hilos, nombresMotor[config.motor]);
+    printf("Claves leidas: %zu - distintas: %zu\n", leidas, trozos[0].cantidad);
+    if (descartadas > 0)
+        printf("Numeros descartados por no entrar en un int: %zu\n", descartadas);
+    if (formato == INGESTA_BINARIO && bytes % sizeof(int) != 0)
+        printf("Se ignoraron los ultimos %zu bytes (no completan un entero).\n", bytes % sizeof(int));
+    printf("Claves nuevas en el motor: %zu\n", nuevas);
+    printf("| %-28s | %-12s | %-10s |\n", "Fase", "Tiempo (ms)", "MB/s");
+    printf("|------------------------------|--------------|------------|\n");
+    printf("| %-28s | %-12.3lf | %-10.1lf |\n", "Lectura, parseo y orden", msParseo, bytes / 1048576.0 / (msParseo / 1000.0));
+    printf("| %-28s | %-12.3lf | %-10s |\n", "Mezcla de trozos", msMezcla, "-");
+    printf("| %-28s | %-12.3lf | %-10s |\n", "Carga en el motor", msCarga, "-");
+
+    free(trozos[0].claves);
+    UnmapViewOfFile(datos);
+    CloseHandle(mapeo);
+    CloseHandle(archivo);
+    return 1;
 }
 
+// ---------------------------------- Modo servidor ----------------------------------
+// Expone el arbol por TCP en 127.0.0.1 con un protocolo binario de tamao fijo. Cada hilo del
+// servidor corre un lazo de eventos con WSAPoll (Windows no tiene epoll) sobre sus conexiones y
+// sobre el socket de escucha, asi las conexiones se reparten entre los hilos que acepten primero.
+// Un cliente puede mandar muchas peticiones sin esperar (pipelining): el servidor procesa todas las
+// completas que haya leido y responde en el mismo orden con un solo send por tanda.
+//
+// Peticion (9 bytes): op (1 byte) + key (int32) + hasta (int32, solo para rango)
+// Respuesta: resultado (int32) - en rango: total (int32) + enviadas (int32) + enviadas claves (int32)
+// Los enteros viajan en el orden de bytes de la maquina (little-endian en x86).
+
+#define PUERTO_POR_DEFECTO 7070
+#define TAM_PETICION 9
+#define TAM_BUFFER_CONEXION 65536
+#define MAX_CLAVES_RANGO 1024       // Claves que viajan como maximo en una respuesta de rango
+#define MAX_CONEXIONES_HILO 256
+#define MAX_HILOS_SERVIDOR 16
+#define MAX_CONEXIONES_CARGA 256
+#define ANCHO_RANGO_CARGA 100       // Claves que abarca cada peticion de rango del generador de carga
+
+enum OpProtocolo {
+    PROTO_INSERTAR = 1,
+    PROTO_BUSCAR = 2,
+    PROTO_ELIMINAR = 3,
+    PROTO_RANGO = 4
+};
 
-// Buscar un valor en un rbol AVL
-/// pre: Requiere un puntero a una estructura nodo, y un valor entero  que se desea buscar como 2do parametro
-///post: Busca un valor en el arbol AVL - Retorna 0 si no lo encuentra - Retorna 1 si esta en el arbol
-int buscarAVL(struct Node* raiz, int key) {
+struct ConexionServidor {
+    SOCKET s;
+    char entrada[TAM_BUFFER_CONEXION];
+    int usadosEntrada;
+    char salida[TAM_BUFFER_CONEXION];
+    int usadosSalida;
+    int enviadosSalida;
+    int cerrando;           // Llego una op invalida: no se lee mas, se envia lo pendiente y se cierra
+};
 
-    if (raiz == NULL) {
-        return 0;  // No encontrado
+struct ServidorAVL {
+    SOCKET escucha;
+    HANDLE hilos[MAX_HILOS_SERVIDOR];
+    int cantidadHilos;
+    int puerto;
+    volatile LONG fin;
+    int activo;
+} servidor = {INVALID_SOCKET, {0}, 0, 0, 0, 0};
+
+/// pre: El socket de la conexion es no bloqueante
+///post: Lee todo lo que entre en el buffer de entrada. Retorna 0 si el cliente cerro o hubo error
+int leerConexion(struct ConexionServidor* c) {
+    while (c->usadosEntrada < TAM_BUFFER_CONEXION) {
+        int leidos = recv(c->s, c->entrada + c->usadosEntrada, TAM_BUFFER_CONEXION - c->usadosEntrada, 0);
+        if (leidos == 0)
+            return 0;
+        if (leidos == SOCKET_ERROR)
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        c->usadosEntrada += leidos;
     }
-    if (key == raiz->key) {
-        return 1;  // Encontrado
-    } else if (key < raiz->key) {
-        return buscarAVL(raiz->left, key);
-    } else {
-        return buscarAVL(raiz->right, key);
+    return 1;
+}
+
+/// pre: El socket de la conexion es no bloqueante
+///post: Envia lo pendiente del buffer de salida. Retorna 0 si hubo error
+int escribirConexion(struct ConexionServidor* c) {
+    while (c->enviadosSalida < c->usadosSalida) {
+        int enviados = send(c->s, c->salida + c->enviadosSalida, c->usadosSalida - c->enviadosSalida, 0);
+        if (enviados == SOCKET_ERROR)
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        c->enviadosSalida += enviados;
     }
+    c->usadosSalida = c->enviadosSalida = 0;
+    return 1;
 }
 
-/// pre: Requiere un nodo raiz como parametro
-///post: Realiza el recorrido in order del AVL ( izquierda - raiz - derecha ) permitiendo imprimir el dato del arbon en orden ascendente
-void printInOrder(struct Node* node) {
-    if (node == NULL)
-        return;
-    printInOrder(node->left);
-    printf("%d ", node->key);
-    printInOrder(node->right);
-}
-
-/// pre: Requiere un nodo
-///post: Retorna el nodo con el valor mnimo (ms a la izquierda), usado para reemplazo en borrado
-struct Node* minValueNode(struct Node* node) {
-    struct Node* current = node;
-    while (current && current->left != NULL)
-        current = current->left;
-    return current;
-}
-
-/// pre: Requiere un nodo y una clave a eliminar
-///post: Elimina el nodo con la clave del AVL y lo rebalancea
-struct Node* deleteNode(struct Node* root, int key) {
-    if (root == NULL)
-        return root;
-
-    if (key < root->key)
-        root->left = deleteNode(root->left, key);
-    else if (key > root->key)
-        root->right = deleteNode(root->right, key);
-    else {
-        // Nodo con un hijo o ninguno
-        if ((root->left == NULL) || (root->right == NULL)) {
-            struct Node* temp = root->left ? root->left : root->right;
-
-            if (temp == NULL) {
-                temp = root;
-                root = NULL;
-            } else {
-                *root = *temp;
+/// pre:
+///post: Ejecuta sobre el arbol todas las peticiones completas del buffer de entrada mientras haya lugar
+///      para su respuesta, y deja en el buffer los bytes de la peticion incompleta. Retorna 0 si llego una op invalida
+int procesarPeticiones(struct ConexionServidor* c) {
+    int pos = 0;
+    int valida = 1;
+
+    while (c->usadosEntrada - pos >= TAM_PETICION) {
+        unsigned char op = (unsigned char)c->entrada[pos];
+        int key, hasta, resultado;
+        int lugarNecesario = (op == PROTO_RANGO) ? (2 + MAX_CLAVES_RANGO) * (int)sizeof(int) : (int)sizeof(int);
+        if (TAM_BUFFER_CONEXION - c->usadosSalida < lugarNecesario)
+            break;  // Se sigue cuando se envie lo acumulado
+
+        memcpy(&key, c->entrada + pos + 1, sizeof(int));
+        memcpy(&hasta, c->entrada + pos + 5, sizeof(int));
+        pos += TAM_PETICION;
+
+        char* respuesta = c->salida + c->usadosSalida;
+        switch (op) {
+            case PROTO_INSERTAR:
+                resultado = insertarClave(key);
+                break;
+            case PROTO_BUSCAR:
+                resultado = buscarConFiltro(key);
+                break;
+            case PROTO_ELIMINAR:
+                resultado = eliminarClave(key);
+                break;
+            case PROTO_RANGO: {
+                int enviadas;
+                resultado = (key <= hasta) ? buscarRango(key, hasta, (int*)(respuesta + 2 * sizeof(int)), MAX_CLAVES_RANGO) : 0;
+                enviadas = resultado < MAX_CLAVES_RANGO ? resultado : MAX_CLAVES_RANGO;
+                memcpy(respuesta + sizeof(int), &enviadas, sizeof(int));
+                c->usadosSalida += (1 + enviadas) * sizeof(int);
+                break;
             }
-
-            free(temp);
-        } else {
-            // Nodo con dos hijos: obtener sucesor en inorden
-            struct Node* temp = minValueNode(root->right);
-            root->key = temp->key;
-            root->right = deleteNode(root->right, temp->key);
+            default:
+                valida = 0;
+                resultado = -1;
         }
+        memcpy(respuesta, &resultado, sizeof(int));
+        c->usadosSalida += sizeof(int);
+        if (!valida)
+            break;
     }
 
-    if (root == NULL)
-        return root;
+    memmove(c->entrada, c->entrada + pos, c->usadosEntrada - pos);
+    c->usadosEntrada -= pos;
+    return valida;
+}
 
-    // Actualizar altura
-    root->height = 1 + mayor(getHeight(root->left), getHeight(root->right));
+/// pre: servidor.escucha es un socket no bloqueante en escucha
+///post: Lazo de eventos de un hilo del servidor: acepta conexiones, lee peticiones, las ejecuta y responde,
+///      hasta que se pida detener el servidor
+DWORD WINAPI threadServidor(LPVOID args) {
+    struct ConexionServidor* conexiones = (struct ConexionServidor*)malloc(MAX_CONEXIONES_HILO * sizeof(struct ConexionServidor));
+    WSAPOLLFD fds[MAX_CONEXIONES_HILO + 1];
+    int cantidad = 0;
+
+    while (!servidor.fin) {
+        fds[0].fd = servidor.escucha;
+        fds[0].events = (cantidad < MAX_CONEXIONES_HILO) ? POLLRDNORM : 0;
+        for (int i = 0; i < cantidad; i++) {
+            struct ConexionServidor* c = &conexiones[i];
+            fds[i + 1].fd = c->s;
+            fds[i + 1].events = 0;
+            if (!c->cerrando && c->usadosEntrada < TAM_BUFFER_CONEXION)
+                fds[i + 1].events |= POLLRDNORM;
+            if (c->usadosSalida > c->enviadosSalida)
+                fds[i + 1].events |= POLLWRNORM;
+        }
 
-    // Obtener balance
-    int balance = getBalanceFactor(root);
+        if (WSAPoll(fds, cantidad + 1, 100) <= 0)
+            continue;   // Vencio la espera: se vuelve a mirar servidor.fin
+
+        int activas = cantidad;
+        if (fds[0].revents & POLLRDNORM) {
+            SOCKET s = accept(servidor.escucha, NULL, NULL);   // Otro hilo puede haberla tomado antes
+            if (s != INVALID_SOCKET) {
+                u_long noBloqueante = 1;
+                int sinDemora = 1;
+                ioctlsocket(s, FIONBIO, &noBloqueante);
+                setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&sinDemora, sizeof(sinDemora));
+                conexiones[cantidad].s = s;
+                conexiones[cantidad].usadosEntrada = 0;
+                conexiones[cantidad].usadosSalida = 0;
+                conexiones[cantidad].enviadosSalida = 0;
+                conexiones[cantidad].cerrando = 0;
+                cantidad++;
+            }
+        }
 
-    // Rebalancear si es necesario
-    if (balance > 1 && getBalanceFactor(root->left) >= 0)
-        return rightRotate(root);
+        // De atras hacia adelante: al cerrar una conexion se la reemplaza por la ultima
+        for (int i = activas - 1; i >= 0; i--) {
+            struct ConexionServidor* c = &conexiones[i];
+            short eventos = fds[i + 1].revents;
+            int viva = 1;
+            if (eventos == 0)
+                continue;
+
+            if (!c->cerrando && (eventos & (POLLRDNORM | POLLHUP | POLLERR)))
+                viva = leerConexion(c);
+            int seguir = viva;
+            while (seguir) {
+                int antes = c->usadosEntrada;
+                if (!c->cerrando)
+                    c->cerrando = !procesarPeticiones(c);
+                viva = escribirConexion(c);
+                // Si se envio todo y quedan peticiones completas que no entraron en la salida (los rangos
+                // reservan mucho lugar) se sigue: el cliente puede estar esperando sin mandar nada mas
+                seguir = viva && !c->cerrando && c->usadosSalida == 0
+                         && c->usadosEntrada >= TAM_PETICION && c->usadosEntrada < antes;
+            }
+            if (viva && c->cerrando && c->usadosSalida == 0)
+                viva = 0;   // Ya salieron las respuestas encoladas y el -1 de la op invalida
 
-    if (balance > 1 && getBalanceFactor(root->left) < 0) {
-        root->left = leftRotate(root->left);
-        return rightRotate(root);
+            if (!viva) {
+                closesocket(c->s);
+                conexiones[i] = conexiones[--cantidad];
+            }
+        }
     }
 
-    if (balance < -1 && getBalanceFactor(root->right) <= 0)
-        return leftRotate(root);
+    for (int i = 0; i < cantidad; i++)
+        closesocket(conexiones[i].s);
+    free(conexiones);
+    return 0;
+}
 
-    if (balance < -1 && getBalanceFactor(root->right) > 0) {
-        root->right = rightRotate(root->right);
-        return leftRotate(root);
-    }
+/// pre: puerto: puerto TCP en 127.0.0.1 - hilos: lazos de eventos a lanzar
+///post: Abre el socket de escucha y lanza los hilos del servidor. Retorna 1 si quedo escuchando
+int iniciarServidor(int puerto, int hilos) {
+    struct sockaddr_in direccion;
+    u_long noBloqueante = 1;
+    int exclusivo = 1;
+
+    if (hilos < 1)
+        hilos = 1;
+    if (hilos > MAX_HILOS_SERVIDOR)
+        hilos = MAX_HILOS_SERVIDOR;
 
-    return root;
+    servidor.escucha = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (servidor.escucha == INVALID_SOCKET)
+        return 0;
+    // Ningun otro proceso puede tomar el mismo puerto mientras el servidor escucha
+    setsockopt(servidor.escucha, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&exclusivo, sizeof(exclusivo));
+
+    memset(&direccion, 0, sizeof(direccion));
+    direccion.sin_family = AF_INET;
+    direccion.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    direccion.sin_port = htons((unsigned short)puerto);
+    if (bind(servidor.escucha, (struct sockaddr*)&direccion, sizeof(direccion)) == SOCKET_ERROR
+        || listen(servidor.escucha, SOMAXCONN) == SOCKET_ERROR) {
+        closesocket(servidor.escucha);
+        servidor.escucha = INVALID_SOCKET;
+        return 0;
+    }
+    ioctlsocket(servidor.escucha, FIONBIO, &noBloqueante);
+
+    servidor.puerto = puerto;
+    servidor.fin = 0;
+    servidor.cantidadHilos = hilos;
+    for (int i = 0; i < hilos; i++)
+        servidor.hilos[i] = CreateThread(NULL, 0, threadServidor, NULL, 0, NULL);
+    servidor.activo = 1;
+    return 1;
 }
 
+/// pre: El servidor esta activo
+///post: Detiene los lazos de eventos, cierra todas las conexiones y el socket de escucha
+void detenerServidor() {
+    servidor.fin = 1;
+    for (int i = 0; i < servidor.cantidadHilos; i++) {
+        WaitForSingleObject(servidor.hilos[i], INFINITE);
+        CloseHandle(servidor.hilos[i]);
+    }
+    closesocket(servidor.escucha);
+    servidor.escucha = INVALID_SOCKET;
+    servidor.activo = 0;
+}
 
-// ---------------------------------- Argumentos para los hilos ----------------------------------
-struct ThreadArgs {
-    int cantidad;   // Cantidad de valores a insertar
-    int min;        // Valor minimo del rango
-    int max;        // Valor maximo del rango
+// Argumentos de cada conexion del generador de carga
+struct ArgsCarga {
+    int puerto;
+    int operaciones;        // Peticiones a enviar por esta conexion
+    int ventana;            // Peticiones enviadas juntas antes de leer las respuestas
+    int min;
+    int max;
+    unsigned int semilla;   // Generador propio: rand() no es seguro entre hilos
+    double* latencias;      // Microsegundos por peticion (operaciones elementos)
+    int completadas;
+    int error;
 };
 
-// ---------------------------------- Funcin que ejecuta cada hilo ----------------------------------
-/// pre:
-///post: Cada hilo genera cantidad nmeros aleatorios entre min y max, y los inserta en el rbol usando mutex para evitar colisiones
-DWORD WINAPI threadInsert(LPVOID args) {
-
-    struct ThreadArgs* ta = (struct ThreadArgs*)args;
-    int inserted = 0;
-
-    while (inserted < ta->cantidad) {
-        int val = rand() % (ta->max - ta->min + 1) + ta->min;
+/// pre: s es un socket bloqueante
+///post: Envia o recibe exactamente bytes. Retorna 0 si la conexion fallo
+int transferirCompleto(SOCKET s, char* buffer, int bytes, int enviar) {
+    int hechos = 0;
+    while (hechos < bytes) {
+        int n = enviar ? send(s, buffer + hechos, bytes - hechos, 0) : recv(s, buffer + hechos, bytes - hechos, 0);
+        if (n <= 0)
+            return 0;
+        hechos += n;
+    }
+    return 1;
+}
 
-        WaitForSingleObject(tree_mutex, INFINITE);  // Bloquear mutex, Bloquea el acceso al rbol
+/// pre: args es una struct ArgsCarga - El servidor escucha en args->puerto
+///post: Abre una conexion y manda las operaciones en ventanas (45% busquedas, 30% inserciones,
+///      20% eliminaciones, 5% rangos), midiendo la latencia de cada una desde que sale su ventana hasta su respuesta
+DWORD WINAPI threadCarga(LPVOID args) {
+    struct ArgsCarga* ca = (struct ArgsCarga*)args;
+    struct sockaddr_in direccion;
+    char* peticiones = (char*)malloc(ca->ventana * TAM_PETICION);
+    int* respuestas = (int*)malloc(ca->ventana * sizeof(int));
+    int* clavesRango = (int*)malloc(MAX_CLAVES_RANGO * sizeof(int));
+    LARGE_INTEGER freq, enviado, recibido;
+    int sinDemora = 1;
+    QueryPerformanceFrequency(&freq);
 
-        if (!buscarAVL(root, val)) {    // Solo insertamos dato  no existe
-            root = insert(root, val);   // Inserta valor
-            inserted++;
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    memset(&direccion, 0, sizeof(direccion));
+    direccion.sin_family = AF_INET;
+    direccion.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    direccion.sin_port = htons((unsigned short)ca->puerto);
+    if (s == INVALID_SOCKET || connect(s, (struct sockaddr*)&direccion, sizeof(direccion)) == SOCKET_ERROR) {
+        ca->error = 1;
+        if (s != INVALID_SOCKET)
+            closesocket(s);
+        free(peticiones);
+        free(respuestas);
+        free(clavesRango);
+        return 0;
+    }
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&sinDemora, sizeof(sinDemora));
+
+    while (ca->completadas < ca->operaciones && !ca->error) {
+        int n = ca->operaciones - ca->completadas;
+        if (n > ca->ventana)
+            n = ca->ventana;
+
+        for (int i = 0; i < n; i++) {
+            ca->semilla = ca->semilla * 1103515245u + 12345u;
+            int dado = (ca->semilla >> 16) % 100;
+            ca->semilla = ca->semilla * 1103515245u + 12345u;
+            int key = (int)((ca->semilla >> 1) % (unsigned int)(ca->max - ca->min + 1)) + ca->min;
+            int hasta = 0;
+            char op = (char)(dado < 45 ? PROTO_BUSCAR : (dado < 75 ? PROTO_INSERTAR : (dado < 95 ? PROTO_ELIMINAR : PROTO_RANGO)));
+            if (op == PROTO_RANGO)
+                hasta = (key > INT_MAX - ANCHO_RANGO_CARGA) ? INT_MAX : key + ANCHO_RANGO_CARGA;
+            peticiones[i * TAM_PETICION] = op;
+            memcpy(peticiones + i * TAM_PETICION + 1, &key, sizeof(int));
+            memcpy(peticiones + i * TAM_PETICION + 5, &hasta, sizeof(int));
         }
 
-        ReleaseMutex(tree_mutex);                   // Liberar mutex, libera el arbol
+        QueryPerformanceCounter(&enviado);
+        if (!transferirCompleto(s, peticiones, n * TAM_PETICION, 1)) {
+            ca->error = 1;
+            break;
+        }
+        // Las respuestas llegan en orden: cada una se fecha cuando se termina de leer
+        for (int i = 0; i < n; i++) {
+            int enviadas = 0;
+            if (!transferirCompleto(s, (char*)&respuestas[i], sizeof(int), 0)) {
+                ca->error = 1;
+                break;
+            }
+            if (peticiones[i * TAM_PETICION] == PROTO_RANGO     // Le siguen enviadas y las claves
+                && (!transferirCompleto(s, (char*)&enviadas, sizeof(int), 0)
+                    || enviadas < 0 || enviadas > MAX_CLAVES_RANGO
+                    || !transferirCompleto(s, (char*)clavesRango, enviadas * sizeof(int), 0))) {
+                ca->error = 1;
+                break;
+            }
+            QueryPerformanceCounter(&recibido);
+            ca->latencias[ca->completadas++] = (double)(recibido.QuadPart - enviado.QuadPart) * 1e6 / freq.QuadPart;
+        }
     }
 
+    closesocket(s);
+    free(peticiones);
+    free(respuestas);
+    free(clavesRango);
     return 0;
 }
 
-void medirTiempoBusqueda(void* arg) {
-    int* val = (int*)arg;
-    buscarAVL(root, *val);
-}
-
-void medirTiempoEliminacion(void* arg) {
-    int* val = (int*)arg;
-    root = deleteNode(root, *val);
-}
-
-void medirTiempoMostrar(void* arg) {
-    printInOrder(root);
+/// pre: a y b apuntan a double
+///post: Compara para qsort en orden ascendente
+int compararDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
 }
 
-void medirInsercionConHilos(int total, int threads, int min, int max) {
-    HANDLE hilos[threads];
-    struct ThreadArgs argumentos[threads];
+/// pre: El servidor escucha en puerto (en este u otro proceso)
+///post: Lanza conexiones concurrentes con pipelining y muestra ops/s y latencias (promedio, p50, p99, max)
+void generadorCarga(int puerto, int conexiones, int operaciones, int ventana, int min, int max) {
+    HANDLE hilos[MAX_CONEXIONES_CARGA];
+    struct ArgsCarga args[MAX_CONEXIONES_CARGA];
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
 
-    for (int i = 0; i < threads; i++) {
-        argumentos[i].cantidad = total / threads;
-        argumentos[i].min = min;
-        argumentos[i].max = max;
+    if (conexiones > MAX_CONEXIONES_CARGA)
+        conexiones = MAX_CONEXIONES_CARGA;
+    int porConexion = operaciones / conexiones;
+    if (porConexion < 1)
+        porConexion = 1;
+
+    for (int i = 0; i < conexiones; i++) {
+        args[i].puerto = puerto;
+        args[i].operaciones = porConexion;
+        args[i].ventana = ventana;
+        args[i].min = min;
+        args[i].max = max;
+        args[i].semilla = (unsigned int)time(NULL) ^ (unsigned int)(i * 2654435761u);
+        args[i].latencias = (double*)malloc(porConexion * sizeof(double));
+        args[i].completadas = 0;
+        args[i].error = 0;
     }
 
-    tiempos.tiempoInsercion = medirTiempo((void (*)(void*))threadInsert, &argumentos[0]);
+    QueryPerformanceCounter(&start);
+    for (int i = 0; i < conexiones; i++)
+        hilos[i] = CreateThread(NULL, 0, threadCarga, &args[i], 0, NULL);
+    for (int i = 0; i < conexiones; i++) {
+        WaitForSingleObject(hilos[i], INFINITE);
+        CloseHandle(hilos[i]);
+    }
+    QueryPerformanceCounter(&end);
 
-    for (int i = 1; i < threads; i++) {
-        hilos[i] = CreateThread(NULL, 0, threadInsert, &argumentos[i], 0, NULL);
+    int total = 0, errores = 0;
+    for (int i = 0; i < conexiones; i++) {
+        total += args[i].completadas;
+        errores += args[i].error;
+    }
+    double* todas = (double*)malloc((total > 0 ? total : 1) * sizeof(double));
+    double suma = 0;
+    int k = 0;
+    for (int i = 0; i < conexiones; i++) {
+        for (int j = 0; j < args[i].completadas; j++) {
+            todas[k++] = args[i].latencias[j];
+            suma += args[i].latencias[j];
+        }
+        free(args[i].latencias);
     }
 
-    // Espera que terminen los hilos
-    for (int i = 1; i < threads; i++) {
-        WaitForSingleObject(hilos[i], INFINITE);
-        CloseHandle(hilos[i]);
+    double segundos = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    printf("\n======== GENERADOR DE CARGA (%d conexiones, ventana %d) ========\n", conexiones, ventana);
+    if (errores > 0)
+        printf("Conexiones con error: %d (el servidor esta activo en el puerto %d?)\n", errores, puerto);
+    if (total > 0) {
+        qsort(todas, total, sizeof(double), compararDouble);
+        printf("Operaciones completadas: %d en %.4lf milisegundos\n", total, segundos * 1000.0);
+        printf("Rendimiento: %.0lf ops/s\n", total / segundos);
+        printf("Latencia (us): promedio %.2lf - p50 %.2lf - p99 %.2lf - max %.2lf\n",
+               suma / total, todas[total / 2], todas[(int)(total * 0.99)], todas[total - 1]);
     }
+    free(todas);
 }
 
-
 // ---------- Funcin principal ----------
 int main() {
 int opcion;
@@ -375,7 +3266,23 @@ int opcion;
     int total, threads, min, max;
     DWORD start, end;
 
-    tree_mutex = CreateMutex(NULL, FALSE, NULL); // Inicializar mutex global
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);           // Winsock para el modo servidor
+    memoriaMarcarBase();                        // La memoria residente que crezca desde aca se compara con la de los nodos
+
+    avlInicializar(&arbol);                     // Inicializa el arbol y su bloqueo
+    bmasInicializar(&arbolBMas);
+    sklInicializar(&listaSkl);
+    captura.tlsHilo = TlsAlloc();               // Numero de hilo dentro de cada grabacion de traza
+    eventoRebalanceo = CreateEvent(NULL, FALSE, FALSE, NULL);
+    papeleraInicializar(&papelera);
+    hiloMantenimiento = CreateThread(NULL, 0, threadMantenimiento, NULL, 0, NULL);
+    publicarVersion(NULL);                      // Version vacia para el modo persistente
+
+    SYSTEM_INFO sistema;
+    GetSystemInfo(&sistema);
+    iniciarPool((int)sistema.dwNumberOfProcessors); // Hilos de trabajo reutilizados por las opciones 1 y 11
+
 
     do {
         printf("\n======= MENU AVL CONCURRENTE =======\n");
@@ -386,6 +3293,19 @@ int opcion;
         printf("5. Mostrar altura y cantidad de nodos\n");
         printf("6. Reiniciar arbol AVL\n");
         printf("7. Mostrar tabla de tiempos y guardar en .txt\n");
+        printf("8. Configurar modos del arbol\n");
+        printf("9. Benchmark de busquedas segun proporcion de fallos\n");
+        printf("10. Validar arbol y mostrar estadisticas de forma\n");
+        printf("11. Benchmark de operaciones asincronas en el pool de hilos\n");
+        printf("12. %s modo servidor (TCP local)\n", servidor.activo ? "Detener" : "Iniciar");
+        printf("13. Generador de carga contra el servidor\n");
+        printf("14. Comparar motores AVL y B+ con la misma carga\n");
+        printf("15. Escalado por hilos: AVL, B+ y skip list sin bloqueos\n");
+        printf("16. Cargar claves desde archivo (mapeado en memoria, en paralelo)\n");
+        printf("17. Benchmark de insercion con dedo segun el orden de las claves\n");
+        printf("18. %s grabacion de traza de operaciones\n", captura.activa ? "Detener" : "Iniciar");
+        printf("19. Reproducir traza de operaciones\n");
+        printf("20. Eliminar o extraer un rango de claves (expiracion)\n");
         printf("0. Salir\n");
         printf("Seleccione una opcion: ");
         scanf("%d", &opcion);
@@ -401,6 +3321,12 @@ int opcion;
                 scanf("%d", &min);
                 printf("Ingrese el valor maximo del rango: ");
                 scanf("%d", &max);
+                int orden;
+                printf("Orden de las claves (%d = %s, %d = %s, %d = %s): ", ORDEN_ALEATORIO, nombresOrden[ORDEN_ALEATORIO],
+                       ORDEN_SECUENCIAL, nombresOrden[ORDEN_SECUENCIAL], ORDEN_CASI_ORDENADO, nombresOrden[ORDEN_CASI_ORDENADO]);
+                scanf("%d", &orden);
+                if (orden < ORDEN_ALEATORIO || orden > ORDEN_CASI_ORDENADO)
+                    orden = ORDEN_ALEATORIO;
 
                 if ((max - min + 1) < total) {
                     printf("El rango es demasiado pequeo para insertar %d valores nicos.\n", total);
@@ -409,7 +3335,19 @@ int opcion;
 
                 srand((unsigned int)time(NULL));  // Inicializar aleatorio
 
-                HANDLE hilos[threads];
+                if (config.filtroBloom) {
+                    // Dimensiona el filtro de una vez para lo que ya hay mas lo que se va a insertar
+                    avlBloquearEscritura(&arbol);
+                    if (filtro.capacidad < filtro.claves + total)
+                        filtroReconstruir(filtro.claves + total);
+                    avlLiberarEscritura(&arbol);
+                }
+
+                if (threads > MAX_HILOS_POOL)
+                    threads = MAX_HILOS_POOL;
+                agrandarPool(threads);          // Los hilos se crean fuera de la medicion
+
+                struct OperacionAVL lotes[threads];
                 struct ThreadArgs args[threads];
 
                 int porHilo = total / threads;
@@ -422,29 +3360,47 @@ int opcion;
                     args[i].cantidad = porHilo + (i < resto ? 1 : 0);
                     args[i].min = min;
                     args[i].max = max;
+                    args[i].orden = orden;
+                    args[i].inicio = (i == 0) ? min : args[i - 1].inicio + args[i - 1].cantidad;   // Bloques contiguos
 
-                    hilos[i] = CreateThread(NULL, 0, threadInsert, &args[i], 0, NULL);
+                    lotes[i].tipo = OP_INSERTAR_ALEATORIOS;
+                    lotes[i].lote = &args[i];
+                    lotes[i].alTerminar = NULL;
                 }
 
-                for (int i = 0; i < threads; i++) {
-                    WaitForSingleObject(hilos[i], INFINITE);
-                    CloseHandle(hilos[i]);
-                }
+                enviarOperaciones(lotes, threads);  // Cada lote lo toma un hilo distinto del pool
+                for (int i = 0; i < threads; i++)
+                    esperarOperacion(&lotes[i]);
 
                 //end = GetTickCount();
                 clock_t end = clock();
                 tiempos.tiempoInsercion = ((double)(end - start)) / CLOCKS_PER_SEC;
                 printf("Tiempo total de insercin: %.4lf milisegundos\n", tiempos.tiempoInsercion);
+                if (config.balanceoRelajado)
+                    printf("Rebalanceos pendientes al terminar: %d\n", pendientes.cantidad);
                 break;
         }
             case 2:{
-                if (root == NULL) {
+                struct VersionAVL* version = NULL;
+                struct Node* raiz = NULL;
+                int vacio;
+                if (config.motor == MOTOR_AVL) {
+                    version = abrirLectura();   // Fija la version o toma el mutex
+                    raiz = version ? version->raiz : arbol.raiz;
+                    vacio = raiz == NULL;
+                } else {
+                    vacio = motorVacio();
+                }
+                if (vacio) {
                     printf("El rbol est vaco.\n");
                 } else {
                     //start = GetTickCount();
                     clock_t start = clock();
                     printf("Recorrido InOrder del rbol: ");
-                    printInOrder(root);
+                    if (config.motor == MOTOR_AVL)
+                        printInOrder(raiz);
+                    else
+                        imprimirMotor();
                     printf("\n");
                     //end = GetTickCount();
                     clock_t end = clock();
@@ -452,17 +3408,41 @@ int opcion;
                     printf("Tiempo de recorrido InOrder: %.4lf milisegundos\n", tiempos.tiempoMostrar);
 
                 }
+                if (config.motor == MOTOR_AVL)
+                    cerrarLectura(version);
                 break;
             }
             case 3:{
-                if (root == NULL) {
+                struct VersionAVL* version = NULL;
+                int vacio;
+                if (config.motor == MOTOR_AVL) {
+                    version = abrirLectura();
+                    vacio = (version ? version->raiz : arbol.raiz) == NULL;
+                    cerrarLectura(version);     // No se retiene el arbol mientras se espera el valor
+                } else {
+                    vacio = motorVacio();
+                }
+                if (vacio) {
                     printf("El rbol est vaco.\n");
                 } else {
                     printf("Ingrese valor a buscar: ");
                     scanf("%d", &valor);
                     //start = GetTickCount();
+                    trazaAnotar(TRAZA_BUSCAR, valor);
                     clock_t start = clock();
-                    int nivel = buscarConProfundidad(root, valor, 0);
+                    int nivel = -1;
+                    if (config.motor != MOTOR_AVL) {
+                        nivel = buscarNivelMotor(valor);
+                    } else {
+                        AcquireSRWLockShared(&lockFiltro);
+                        int puedeEstar = !config.filtroBloom || filtroConsultar(&filtro, valor);
+                        ReleaseSRWLockShared(&lockFiltro);
+                        if (puedeEstar) {       // Si el filtro descarta la clave no se toca el arbol
+                            version = abrirLectura();
+                            nivel = buscarConProfundidad(version ? version->raiz : arbol.raiz, valor, 0);
+                            cerrarLectura(version);
+                        }
+                    }
                     clock_t end = clock();
                     tiempos.tiempoBusqueda = ((double)(end - start)) / CLOCKS_PER_SEC;
 
@@ -476,7 +3456,15 @@ int opcion;
                 break;
             }
             case 4:{
-                if (root == NULL) {
+                int vacio;
+                if (config.motor == MOTOR_AVL) {
+                    avlBloquearEscritura(&arbol);
+                    vacio = config.versionesPersistentes ? versionActual->raiz == NULL : arbol.raiz == NULL;
+                    avlLiberarEscritura(&arbol);
+                } else {
+                    vacio = motorVacio();
+                }
+                if (vacio) {
                     printf("El rbol est vaco.\n");
                 } else {
                         int valor;
@@ -484,8 +3472,7 @@ int opcion;
                         scanf("%d", &valor);
                         //start = GetTickCount();
                         clock_t start = clock();
-                    if (buscarAVL(root, valor)) {
-                        root = deleteNode(root, valor);
+                    if (eliminarClave(valor)) {
                         //end = GetTickCount();
                         clock_t end = clock();
                         tiempos.tiempoEliminacion = ((double)(end - start)) / CLOCKS_PER_SEC;
@@ -502,29 +3489,59 @@ int opcion;
             }
             case 5:{
                 // Mostrar cantidad de nodos, altura y memoria utilizada
-                if (root == NULL) {
+                if (config.motor != MOTOR_AVL) {
+                    mostrarTamanioMotor();
+                    break;
+                }
+                struct VersionAVL* version = abrirLectura();
+                struct Node* raiz = version ? version->raiz : arbol.raiz;
+                if (raiz == NULL) {
                     printf("El rbol est vaco.\n");
                 } else {
-                    int altura = calcularAltura(root);
-                    int nodos = contarNodos(root);
-                    size_t memoria = nodos * sizeof(struct Node);
+                    int altura = calcularAltura(raiz);
+                    int nodos = contarNodos(raiz);
+                    int enCola = pendientes.cantidad;
                     printf("Altura del rbol: %d\n", altura);
                     printf("Cantidad de nodos: %d\n", nodos);
-                    printf("Uso aproximado de memoria: %zu bytes\n", memoria);
+                    // Con versiones persistentes el heap incluye los nodos que solo usan versiones viejas
+                    memoriaMostrar(stdout, MEMORIA_AVL, recolectarRango(raiz, INT_MIN, INT_MAX, NULL, 0, 0));
+                    if (enCola > 0)
+                        printf("Rebalanceos pendientes: %d (la altura puede superar la cota AVL)\n", enCola);
+                    if (borrados.cantidad > 0)
+                        printf("Borrados logicos sin compactar: %d (umbral %d)\n", borrados.cantidad, config.umbralCompactacion);
                 }
+                cerrarLectura(version);
                 break;
             }
             case 6:{
                 // Reinicia el rbol borrando todos los nodos
-                if (root != NULL) {
+                if (config.motor != MOTOR_AVL) {
+                    if (reiniciarMotor())
+                        printf("Arbol reiniciado correctamente.\n");
+                    else
+                        printf("El arbol ya esta vacio.\n");
+                    break;
+                }
+                avlBloquearEscritura(&arbol);
+                if (config.versionesPersistentes && versionActual->raiz != NULL) {
+                    publicarVersion(NULL);  // Los nodos se liberan cuando ningun lector use la version anterior
+                    if (config.filtroBloom)
+                        filtroReconstruir(0);
+                    printf("rbol reiniciado correctamente.\n");
+                } else if (arbol.raiz != NULL) {
                     // Liberar memoria recursivamente
-                    while (root != NULL) {
-                        root = deleteNode(root, root->key);
-                    }
+                    liberarArbol(arbol.raiz);
+                    arbol.raiz = NULL;
+                    dedoReiniciar(&dedoArbol);
+                    pendientes.inicio = 0;
+                    pendientes.cantidad = 0;
+                    if (config.filtroBloom)
+                        filtroReconstruir(0);
                     printf("rbol reiniciado correctamente.\n");
                 } else {
                     printf("El rbol ya est vaco.\n");
                 }
+                avlLiberarEscritura(&arbol);
                 break;
             }
             case 0:{
@@ -541,6 +3558,7 @@ int opcion;
             printf("| %-25s | %-10.4lf |\n", "Mostrar (InOrder)", tiempos.tiempoMostrar);
             printf("| %-25s | %-10.4lf |\n", "Busqueda", tiempos.tiempoBusqueda);
             printf("| %-25s | %-10.4lf |\n", "Busqueda + Eliminacion", tiempos.tiempoEliminacion);
+            escribirContadores(stdout);
 
             // Guardar resultados en archivo
             FILE* archivo = fopen("concurrente_tiempos_avl.txt", "w");
@@ -552,6 +3570,7 @@ int opcion;
                 fprintf(archivo, "| %-25s | %-10.4lf |\n", "Mostrar (InOrder)", tiempos.tiempoMostrar);
                 fprintf(archivo, "| %-25s | %-10.4lf |\n", "Busqueda", tiempos.tiempoBusqueda);
                 fprintf(archivo, "| %-25s | %-10.4lf |\n", "Busqueda + Eliminacion", tiempos.tiempoEliminacion);
+                escribirContadores(archivo);
                 fclose(archivo);
                 printf("Los tiempos fueron guardados en 'concurrente_tiempos_avl.txt'.\n");
             } else {
@@ -559,6 +3578,391 @@ int opcion;
             }
 
             break;}
+            case 8:{
+                // Submenu de configuracion de los modos del arbol
+                int modo;
+                printf("\n------- CONFIGURACION -------\n");
+                printf("1. Balanceo %s (cambiar a %s)\n",
+                       config.balanceoRelajado ? "relajado" : "estricto",
+                       config.balanceoRelajado ? "estricto" : "relajado");
+                printf("2. Versiones persistentes %s (cambiar a %s)\n",
+                       config.versionesPersistentes ? "activadas" : "desactivadas",
+                       config.versionesPersistentes ? "desactivadas" : "activadas");
+                printf("3. Filtro de Bloom %s (cambiar a %s)\n",
+                       config.filtroBloom ? "activado" : "desactivado",
+                       config.filtroBloom ? "desactivado" : "activado");
+                printf("4. Motor %s (cambiar, se pasan las claves)\n", nombresMotor[config.motor]);
+                printf("5. Borrado %s (umbral de compactacion: %d)\n",
+                       config.borradoLogico ? "logico" : "inmediato", config.umbralCompactacion);
+                printf("6. Insercion %s (cambiar a %s)\n",
+                       config.insercionConDedo ? "con dedo" : "desde la raiz",
+                       config.insercionConDedo ? "desde la raiz" : "con dedo");
+                printf("0. Volver\n");
+                printf("Seleccione una opcion: ");
+                scanf("%d", &modo);
+
+                if (modo == 1) {
+                    if (config.balanceoRelajado)
+                        drenarRebalanceo();     // Vuelve a dejar el arbol AVL estricto
+                    config.balanceoRelajado = !config.balanceoRelajado;
+                    printf("Balanceo %s activado.\n", config.balanceoRelajado ? "relajado" : "estricto");
+                    if (config.versionesPersistentes)
+                        printf("Mientras las versiones persistentes esten activas se usa balanceo estricto.\n");
+                } else if ((modo == 2 || modo == 3 || modo == 5 || modo == 6) && config.motor != MOTOR_AVL) {
+                    printf("Disponible solo con el motor AVL.\n");
+                } else if ((modo == 2 && !config.versionesPersistentes && config.borradoLogico) ||
+                           (modo == 5 && config.versionesPersistentes)) {
+                    printf("El borrado logico y las versiones persistentes no se pueden combinar.\n");
+                } else if (modo == 2) {
+                    drenarRebalanceo();
+                    avlBloquearEscritura(&arbol);
+                    if (config.versionesPersistentes) {
+                        // Copia la version vigente a un arbol modificable y publica una version vacia
+                        arbol.raiz = copiarArbol(versionActual->raiz);
+                        publicarVersion(NULL);
+                    } else {
+                        // Cada nodo del arbol modificable tiene un solo padre (refs = 1): se publica tal cual
+                        publicarVersion(arbol.raiz);
+                        arbol.raiz = NULL;
+                    }
+                    config.versionesPersistentes = !config.versionesPersistentes;
+                    dedoReiniciar(&dedoArbol);
+                    avlLiberarEscritura(&arbol);
+                    printf("Versiones persistentes %s.\n", config.versionesPersistentes ? "activadas" : "desactivadas");
+                } else if (modo == 3) {
+                    avlBloquearEscritura(&arbol);
+                    config.filtroBloom = !config.filtroBloom;
+                    if (config.filtroBloom)
+                        filtroReconstruir(0);   // Se dimensiona segun los nodos actuales
+                    else
+                        filtroDescartar();
+                    avlLiberarEscritura(&arbol);
+                    printf("Filtro de Bloom %s.\n", config.filtroBloom ? "activado" : "desactivado");
+                } else if (modo == 4) {
+                    int destino;
+                    printf("Motor (%d = %s, %d = %s, %d = %s): ", MOTOR_AVL, nombresMotor[MOTOR_AVL],
+                           MOTOR_BMAS, nombresMotor[MOTOR_BMAS], MOTOR_SKIPLIST, nombresMotor[MOTOR_SKIPLIST]);
+                    scanf("%d", &destino);
+                    if (destino < MOTOR_AVL || destino > MOTOR_SKIPLIST || destino == config.motor) {
+                        printf("Se mantiene el motor %s.\n", nombresMotor[config.motor]);
+                    } else if (config.versionesPersistentes) {
+                        printf("Desactive las versiones persistentes antes de cambiar de motor.\n");
+                    } else if (servidor.activo) {
+                        printf("Detenga el servidor antes de cambiar de motor.\n");
+                    } else {
+                        cambiarMotor(destino);
+                        printf("Motor %s activado.\n", nombresMotor[config.motor]);
+                    }
+                } else if (modo == 5) {
+                    int logico, umbral;
+                    printf("Borrado (0 = inmediato, 1 = logico con compactacion): ");
+                    scanf("%d", &logico);
+                    if (logico) {
+                        printf("Borrados logicos que disparan la compactacion: ");
+                        scanf("%d", &umbral);
+                        config.umbralCompactacion = umbral > 0 ? umbral : UMBRAL_COMPACTACION;
+                        config.borradoLogico = 1;
+                        printf("Borrado logico activado (umbral %d).\n", config.umbralCompactacion);
+                    } else {
+                        config.borradoLogico = 0;
+                        int quitados = compactarBorrados();     // No deja nodos marcados en el arbol
+                        printf("Borrado inmediato activado (%d nodos compactados).\n", quitados);
+                    }
+                } else if (modo == 6) {
+                    avlBloquearEscritura(&arbol);
+                    config.insercionConDedo = !config.insercionConDedo;
+                    dedoReiniciar(&dedoArbol);
+                    avlLiberarEscritura(&arbol);
+                    printf("Insercion %s activada.\n", config.insercionConDedo ? "con dedo" : "desde la raiz");
+                    if (config.versionesPersistentes || config.balanceoRelajado)
+                        printf("Mientras las versiones persistentes o el balanceo relajado esten activos no se usa el dedo.\n");
+                }
+                break;
+            }
+            case 9:{
+                // Benchmark de busquedas con y sin filtro de Bloom
+                if (config.motor != MOTOR_AVL) {
+                    printf("Disponible solo con el motor AVL.\n");
+                    break;
+                }
+                avlBloquearEscritura(&arbol);
+                int vacio = (config.versionesPersistentes ? versionActual->raiz : arbol.raiz) == NULL;
+                avlLiberarEscritura(&arbol);
+                if (vacio) {
+                    printf("El arbol esta vacio.\n");
+                } else {
+                    int consultas;
+                    printf("Cantidad de busquedas por medicion: ");
+                    scanf("%d", &consultas);
+                    if (consultas > 0)
+                        benchmarkFiltroBloom(consultas);
+                }
+                break;
+            }
+            case 10:{
+                // Validacion paralela de invariantes BST/AVL y estadisticas de forma
+                if (config.motor != MOTOR_AVL) {
+                    printf("Disponible solo con el motor AVL.\n");
+                    break;
+                }
+                SYSTEM_INFO sistema;
+                GetSystemInfo(&sistema);
+                struct EstadisticasAVL stats;
+                LARGE_INTEGER freq, start, end;
+                QueryPerformanceFrequency(&freq);
+
+                struct VersionAVL* version = abrirLectura();    // El arbol no cambia mientras se valida
+                int enCola = pendientes.cantidad;
+                QueryPerformanceCounter(&start);
+                validarArbol(version ? version->raiz : arbol.raiz, (int)sistema.dwNumberOfProcessors, &stats);
+                QueryPerformanceCounter(&end);
+                cerrarLectura(version);
+
+                mostrarEstadisticas(&stats, (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+                if (enCola > 0)
+                    printf("Hay %d rebalanceos pendientes: las alturas y balances pueden no estar corregidos aun.\n", enCola);
+                break;
+            }
+            case 11:{
+                // Operaciones mezcladas enviadas al pool sin esperar una por una
+                int cantidad, lote;
+                printf("Cantidad de operaciones: ");
+                scanf("%d", &cantidad);
+                printf("Operaciones enviadas por lote: ");
+                scanf("%d", &lote);
+                printf("Ingrese el valor minimo del rango: ");
+                scanf("%d", &min);
+                printf("Ingrese el valor maximo del rango: ");
+                scanf("%d", &max);
+
+                if (cantidad <= 0 || lote <= 0 || max < min) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+                benchmarkAsincrono(cantidad, min, max, lote);
+                break;
+            }
+            case 12:{
+                // Inicia o detiene el servidor TCP en 127.0.0.1
+                if (servidor.activo) {
+                    detenerServidor();
+                    printf("Servidor detenido.\n");
+                    break;
+                }
+                int puerto, hilosServidor;
+                printf("Puerto (0 = %d): ", PUERTO_POR_DEFECTO);
+                scanf("%d", &puerto);
+                printf("Hilos del servidor: ");
+                scanf("%d", &hilosServidor);
+                if (puerto <= 0)
+                    puerto = PUERTO_POR_DEFECTO;
+
+                if (iniciarServidor(puerto, hilosServidor))
+                    printf("Servidor escuchando en 127.0.0.1:%d con %d hilos.\n", puerto, servidor.cantidadHilos);
+                else
+                    printf("No se pudo abrir el puerto %d.\n", puerto);
+                break;
+            }
+            case 13:{
+                // Carga de varias conexiones con pipelining contra el servidor
+                int puerto, conexiones, operaciones, ventana;
+                printf("Puerto (0 = %d): ", PUERTO_POR_DEFECTO);
+                scanf("%d", &puerto);
+                printf("Cantidad de conexiones: ");
+                scanf("%d", &conexiones);
+                printf("Cantidad total de operaciones: ");
+                scanf("%d", &operaciones);
+                printf("Peticiones en vuelo por conexion (ventana): ");
+                scanf("%d", &ventana);
+                printf("Ingrese el valor minimo del rango: ");
+                scanf("%d", &min);
+                printf("Ingrese el valor maximo del rango: ");
+                scanf("%d", &max);
+                if (puerto <= 0)
+                    puerto = PUERTO_POR_DEFECTO;
+
+                if (conexiones <= 0 || operaciones <= 0 || ventana <= 0 || max < min) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+                generadorCarga(puerto, conexiones, operaciones, ventana, min, max);
+                break;
+            }
+            case 14:{
+                // Misma carga sobre un AVL y un B+ locales, sin bloqueos
+                int cantidad;
+                printf("Cantidad de claves: ");
+                scanf("%d", &cantidad);
+                printf("Ingrese el valor minimo del rango: ");
+                scanf("%d", &min);
+                printf("Ingrese el valor maximo del rango: ");
+                scanf("%d", &max);
+
+                if (cantidad <= 0 || max < min) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+                compararMotores(cantidad, min, max);
+                break;
+            }
+            case 15:{
+                // Misma mezcla de operaciones con 1 a 64 hilos en cada motor
+                int operaciones, rango;
+                printf("Cantidad total de operaciones por medicion: ");
+                scanf("%d", &operaciones);
+                printf("Rango de claves (se precarga la mitad): ");
+                scanf("%d", &rango);
+
+                int cerrojo = 0;
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+                printf("Cerrojo de AVL y B+ (%d = %s, %d = %s): ", CERROJO_SISTEMA, nombresCerrojo[CERROJO_SISTEMA],
+                       CERROJO_GIRO, nombresCerrojo[CERROJO_GIRO]);
+                scanf("%d", &cerrojo);
+                cerrojo = cerrojo == CERROJO_SISTEMA ? CERROJO_SISTEMA : CERROJO_GIRO;
+#endif
+
+                if (operaciones <= 0 || rango <= 1) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+                benchmarkEscalado(operaciones, rango, cerrojo);
+                break;
+            }
+            case 16:{
+                // Ingesta de un archivo grande con todos los hilos
+                char ruta[MAX_PATH];
+                int formato;
+                printf("Ruta del archivo: ");
+                scanf(" %259[^\n]", ruta);
+                printf("Formato (%d = texto, %d = binario int32): ", INGESTA_TEXTO, INGESTA_BINARIO);
+                scanf("%d", &formato);
+                printf("Cantidad de hilos (0 = uno por procesador): ");
+                scanf("%d", &threads);
+
+                if (formato != INGESTA_TEXTO && formato != INGESTA_BINARIO) {
+                    printf("Formato invalido.\n");
+                    break;
+                }
+                if (threads <= 0) {
+                    SYSTEM_INFO info;
+                    GetSystemInfo(&info);
+                    threads = (int)info.dwNumberOfProcessors;
+                }
+                if (!ingerirArchivo(ruta, formato, threads))
+                    printf("No se pudo abrir o mapear el archivo (o esta vacio).\n");
+                break;
+            }
+            case 17:{
+                // Mismas claves desde la raiz y con dedo, en orden aleatorio, secuencial y casi ordenado
+                int cantidad;
+                printf("Cantidad de claves: ");
+                scanf("%d", &cantidad);
+                if (cantidad <= 0) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+                benchmarkDedo(cantidad);
+                break;
+            }
+            case 18:{
+                // Graba lo que entra por las opciones, el pool y el servidor hasta volver a elegir la opcion
+                if (captura.activa) {
+                    if (detenerGrabacion())
+                        printf("Traza guardada en %s\n", captura.ruta);
+                    else
+                        printf("No se pudo escribir %s\n", captura.ruta);
+                    break;
+                }
+                char ruta[MAX_PATH];
+                int capacidad;
+                printf("Archivo de la traza: ");
+                scanf("%259s", ruta);
+                printf("Maximo de operaciones a grabar: ");
+                scanf("%d", &capacidad);
+                if (capacidad <= 0) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+                if (iniciarGrabacion(ruta, capacidad))
+                    printf("Grabando (%d claves en la foto inicial). Elija 18 de nuevo para detener.\n", captura.cantidadClaves);
+                else
+                    printf("No hay memoria para %d operaciones.\n", capacidad);
+                break;
+            }
+            case 19:{
+                // Reproduce una traza sobre un motor local, sin tocar el arbol del menu
+                char ruta[MAX_PATH];
+                int motor, hilosReproduccion, ritmo, cerrojo = 0;
+                printf("Archivo de la traza: ");
+                scanf("%259s", ruta);
+                printf("Motor (%d = %s, %d = %s, %d = %s): ", MOTOR_AVL, nombresMotor[MOTOR_AVL],
+                       MOTOR_BMAS, nombresMotor[MOTOR_BMAS], MOTOR_SKIPLIST, nombresMotor[MOTOR_SKIPLIST]);
+                scanf("%d", &motor);
+                printf("Hilos de reproduccion (1 a %d): ", ESCALADO_HILOS_MAXIMO);
+                scanf("%d", &hilosReproduccion);
+                printf("Ritmo (0 = lo mas rapido posible, 1 = original): ");
+                scanf("%d", &ritmo);
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+                printf("Cerrojo de AVL y B+ (%d = %s, %d = %s): ", CERROJO_SISTEMA, nombresCerrojo[CERROJO_SISTEMA],
+                       CERROJO_GIRO, nombresCerrojo[CERROJO_GIRO]);
+                scanf("%d", &cerrojo);
+                cerrojo = cerrojo == CERROJO_SISTEMA ? CERROJO_SISTEMA : CERROJO_GIRO;
+#endif
+                if (motor < MOTOR_AVL || motor > MOTOR_SKIPLIST || hilosReproduccion < 1 || hilosReproduccion > ESCALADO_HILOS_MAXIMO) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+                if (!reproducirTraza(ruta, motor, hilosReproduccion, ritmo != 0, cerrojo))
+                    printf("No se pudo leer %s o no es una traza valida.\n", ruta);
+                break;
+            }
+            case 20:{
+                // Quita un rango entero de una vez: en el AVL parte y une en lugar de borrar clave por clave
+                int modo, desde, hasta;
+                printf("Modo (1 = eliminar y liberar en segundo plano, 2 = extraer y mostrar, 3 = comparar contra borrar clave por clave): ");
+                scanf("%d", &modo);
+                if (modo == 3) {
+                    int cantidad;
+                    printf("Cantidad de claves: ");
+                    scanf("%d", &cantidad);
+                    if (cantidad <= 1) {
+                        printf("Parametros invalidos.\n");
+                        break;
+                    }
+                    benchmarkExpiracion(cantidad);
+                    break;
+                }
+                printf("Desde (clave minima del rango): ");
+                scanf("%d", &desde);
+                printf("Hasta (clave maxima del rango): ");
+                scanf("%d", &hasta);
+                if ((modo != 1 && modo != 2) || desde > hasta) {
+                    printf("Parametros invalidos.\n");
+                    break;
+                }
+
+                struct Node* rango = NULL;
+                int partiendo = config.motor == MOTOR_AVL && !config.versionesPersistentes;
+                LARGE_INTEGER frecuencia, t0, t1;
+                QueryPerformanceFrequency(&frecuencia);
+                QueryPerformanceCounter(&t0);
+                int quitado = eliminarRango(desde, hasta, modo == 2 ? &rango : NULL);
+                QueryPerformanceCounter(&t1);
+                double ms = (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / frecuencia.QuadPart;
+
+                if (!quitado) {
+                    printf("No hay claves en [%d, %d].\n", desde, hasta);
+                } else if (modo == 1) {
+                    printf("Rango [%d, %d] quitado en %.3lf ms%s.\n", desde, hasta, ms,
+                           partiendo ? "; sus nodos se liberan en segundo plano" : " (clave por clave)");
+                } else {
+                    printf("Claves extraidas (%d) en %.3lf ms: ", recolectarRango(rango, INT_MIN, INT_MAX, NULL, 0, 0), ms);
+                    printInOrder(rango);
+                    printf("\n");
+                    liberarArbol(rango);
+                }
+                break;
+            }
             default:
                 printf("Opcin invlida. Intente de nuevo.\n");
         }
@@ -566,7 +3970,22 @@ int opcion;
     } while (opcion != 0);
 
     // Liberar recursos
-    CloseHandle(tree_mutex);            // Cierra el mutex
+    if (servidor.activo)
+        detenerServidor();
+    if (captura.activa && detenerGrabacion())   // No se pierde una traza que quedo grabando
+        printf("Traza guardada en %s\n", captura.ruta);
+    cerrarPool();
+    finMantenimiento = 1;               // Detiene el hilo de mantenimiento
+    SetEvent(eventoRebalanceo);
+    WaitForSingleObject(hiloMantenimiento, INFINITE);
+    CloseHandle(hiloMantenimiento);
+    CloseHandle(eventoRebalanceo);
+    papeleraLiberar(&papelera, 0);      // Lo que el mantenimiento no llego a liberar
+    soltarVersion(versionActual);
+    avlDestruir(&arbol);                // Libera los nodos y el bloqueo
+    bmasDestruir(&arbolBMas);
+    sklDestruir(&listaSkl);
+    WSACleanup();
 
     return 0;
 }
@@ -0,0 +1,931 @@
+#include <limits.h>     // LLONG_MIN/LLONG_MAX: rangos abiertos del dedo - INT_MAX: fin de rango
+#include "avl.h"
+
+// ---------------------------------- Funciones del AVL ----------------------------------
+// Ninguna de estas funciones toma bloqueos: el llamador decide (ver avlInsertar, avlEliminar,
+// avlContiene y avlBloquearEscritura/avlBloquearLectura en avl.h).
+
+/// pre: Requiere un nodo en argumento
+///post: Retorna la altura del nodo - 0 si es NULL
+int getHeight(struct Node* n) {
+    return (n == NULL) ? 0 : n->height;
+}
+
+/// pre: a y b son valores enteros
+///post: Compara a y b, retornando el valor mas grande
+int mayor(int a, int b) {
+    return (a > b) ? a : b;
+}
+
+/// pre: key es el dato, siendo un valor entero
+///post: Crea e inicialia un nuevo nodo con el valor del dato key ingresado x parametro
+struct Node* createNode(int key) {
+    struct Node* node = (struct Node*)memoriaReservar(MEMORIA_AVL, sizeof(struct Node));
+    AVL_CONTAR(reservas, 1);
+    node->key = key;
+    node->left = NULL;
+    node->right = NULL;
+    node->height = 1; // <--- EL nuevo nodo se agrega en la hoja
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    node->refs = 1;
+    node->borrado = 0;
+#endif
+#if AVL_SINCRONIZACION == AVL_SINC_FINA
+    InitializeSRWLock(&node->lock);
+#endif
+    return node;
+}
+
+/// pre: nodo viene de createNode y ya no esta enlazado en ningun arbol
+///post: Devuelve su memoria descontandola de MEMORIA_AVL
+void liberarNodo(struct Node* nodo) {
+    memoriaLiberar(MEMORIA_AVL, nodo, sizeof(struct Node));
+}
+
+/// pre: Requiere un Nodo como parametro
+///post: Calcula el balance del nodo para saber si hay que rotar
+///         como la diferencia de altura entre sus subarboles izquierdo y derecho - Retorna 0 si es NULL
+int getBalanceFactor(struct Node* n) {
+    if (n == NULL)
+        return 0;
+    return getHeight(n->left) - getHeight(n->right);
+}
+
+/// pre: Requiere  un nodo como argumento
+///post: Realiza una rotacion simple a la derecha
+///     para mantener el equilibrio del arbo tras cada insercion si esta desbalanceado por izquierda
+struct Node* rightRotate(struct Node* y) {
+    struct Node* x = y->left;
+    struct Node* T2 = x->right;
+
+    // Realiza la rotacion
+    x->right = y;
+    y->left = T2;
+
+    // Actualiza altura
+    y->height = mayor(getHeight(y->left), getHeight(y->right)) + 1;
+    x->height = mayor(getHeight(x->left), getHeight(x->right)) + 1;
+
+    return x;
+}
+
+/// pre: Requiere  un nodo como argumento
+///post: Realiza una rotacion simple a la izquierda
+///     para mantener el equilibrio del arbo tras cada insercion si esta desbalanceado por derecha
+struct Node* leftRotate(struct Node* x) {
+    struct Node* y = x->right;
+    struct Node* T2 = y->left;
+
+    // Realiza la rotacion
+    y->left = x;
+    x->right = T2;
+
+    // Actualiza altura
+    x->height = mayor(getHeight(x->left), getHeight(x->right)) + 1;
+    y->height = mayor(getHeight(y->left), getHeight(y->right)) + 1;
+
+    return y;
+}
+
+/// pre: node no es NULL, su hijo del lado de key ya se inserto y rebalanceo
+///post: Actualiza la altura del nodo y ejecuta la rotacion que corresponda (1 de 4 casos).
+///      Retorna la nueva raiz del subarbol
+static struct Node* rebalancearInsercion(struct Node* node, int key) {
+    // Actualiza altura del nodo padre
+    node->height = 1 + mayor(getHeight(node->left), getHeight(node->right));
+
+    // Obtiene el factor de equilibrio del nodo padre para corroborar que no se haya producido un desequilibrio
+    int balance = getBalanceFactor(node);
+
+    // Existen 4 casos si el nodo se encuentra desquilibrado:
+
+    // 1. Caso rotacion simple a la derecha
+    if (balance > 1 && key < node->left->key) {
+        AVL_CONTAR(rotacionesSimples, 1);
+        return rightRotate(node);
+    }
+
+    // 2. Caso rotacion simple a la izquierda
+    if (balance < -1 && key > node->right->key) {
+        AVL_CONTAR(rotacionesSimples, 1);
+        return leftRotate(node);
+    }
+
+    // 3. Caso rotacion izquierda-derecha
+    if (balance > 1 && key > node->left->key) {
+        AVL_CONTAR(rotacionesDobles, 1);
+        node->left = leftRotate(node->left);
+        return rightRotate(node);
+    }
+
+    // 4. Caso rotacion derecha-izquierda
+    if (balance < -1 && key < node->right->key) {
+        AVL_CONTAR(rotacionesDobles, 1);
+        node->right = rightRotate(node->right);
+        return leftRotate(node);
+    }
+
+    return node; // Nodo ya balanceado
+}
+
+/// pre: Requiere un puntero al nodo y el dato siendo un entero que se quiera insertar en el AVL
+///post: funcion recursiva, inserta un dato al arbol.
+///     Si el nodo actual es NULL, crea uno.
+///     Si el valor existe, no se inserta por no admitir duplicados
+///     Al insertar el dato, se actualiza la altura del nodo y se calcula su balance.
+///     Si esta desquilibrado, se ejecutan 1 de las 4 posibles rotaciones necesarias.
+struct Node* insert(struct Node* node, int key) {
+
+    // Realiza la insercion del arbol de busqueda binario
+    if (node == NULL) {
+        AVL_CONTAR_REBALANCEO();    // Los ancestros que cambien de aca para arriba son su propagacion
+        return createNode(key); // Caso base: nodo vacio, se crea uno nuevo
+    }
+
+    int alturaPrevia = node->height;
+    if (key < node->key)
+        node->left = insert(node->left, key);
+    else if (key > node->key)
+        node->right = insert(node->right, key);
+    else { // No se permiten datos duplicados: si estaba borrado logicamente vuelve a estar
+        revivirNodo(node);
+        return node;
+    }
+
+    struct Node* raiz = rebalancearInsercion(node, key);
+    AVL_CONTAR_NIVEL_SI(raiz != node || raiz->height != alturaPrevia);
+    return raiz;
+}
+
+/// pre: Requiere un nodo
+///post: Retorna el nodo con el valor minimo (mas a la izquierda), usado para reemplazo en borrado - NULL si node es NULL
+struct Node* minValueNode(struct Node* node) {
+    struct Node* current = node;
+    while (current && current->left != NULL)
+        current = current->left;
+    return current;
+}
+
+/// pre: Requiere un nodo y una clave a eliminar
+///post: Elimina el nodo con la clave del AVL y lo rebalancea
+struct Node* deleteNode(struct Node* root, int key) {
+    if (root == NULL)
+        return root;
+
+    if (key < root->key)
+        root->left = deleteNode(root->left, key);
+    else if (key > root->key)
+        root->right = deleteNode(root->right, key);
+    else {
+        // Nodo con un hijo o ninguno
+        if ((root->left == NULL) || (root->right == NULL)) {
+            struct Node* temp = root->left ? root->left : root->right;
+
+            if (temp == NULL) {
+                temp = root;
+                root = NULL;
+            } else {
+                *root = *temp; // Copia los datos
+            }
+
+            liberarNodo(temp);
+            AVL_CONTAR(liberaciones, 1);
+            AVL_CONTAR_REBALANCEO();
+        } else {
+            // Nodo con dos hijos: obtener sucesor en inorden
+            struct Node* temp = minValueNode(root->right);
+            root->key = temp->key;
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+            root->borrado = temp->borrado;  // La marca va con la clave
+#endif
+            root->right = deleteNode(root->right, temp->key);
+        }
+    }
+
+    // Si el arbol tenia un solo nodo
+    if (root == NULL)
+        return root;
+
+    // Actualizar altura
+    int alturaPrevia = root->height;
+    root->height = 1 + mayor(getHeight(root->left), getHeight(root->right));
+
+    // Obtener balance
+    int balance = getBalanceFactor(root);
+
+    // Rebalancear si es necesario
+    if (balance > 1 && getBalanceFactor(root->left) >= 0) {
+        AVL_CONTAR(rotacionesSimples, 1);
+        AVL_CONTAR_NIVEL_SI(1);
+        return rightRotate(root);
+    }
+
+    if (balance > 1 && getBalanceFactor(root->left) < 0) {
+        AVL_CONTAR(rotacionesDobles, 1);
+        AVL_CONTAR_NIVEL_SI(1);
+        root->left = leftRotate(root->left);
+        return rightRotate(root);
+    }
+
+    if (balance < -1 && getBalanceFactor(root->right) <= 0) {
+        AVL_CONTAR(rotacionesSimples, 1);
+        AVL_CONTAR_NIVEL_SI(1);
+        return leftRotate(root);
+    }
+
+    if (balance < -1 && getBalanceFactor(root->right) > 0) {
+        AVL_CONTAR(rotacionesDobles, 1);
+        AVL_CONTAR_NIVEL_SI(1);
+        root->right = rightRotate(root->right);
+        return leftRotate(root);
+    }
+
+    AVL_CONTAR_NIVEL_SI(root->height != alturaPrevia);
+    return root;
+}
+
+// Buscar un valor en un arbol AVL
+/// pre: Requiere un puntero a una estructura nodo, y un valor entero  que se desea buscar como 2do parametro
+///post: Busca un valor en el arbol AVL - Retorna 0 si no lo encuentra o esta borrado logicamente -
+///      Retorna 1 si esta en el arbol. Iterativa: es el camino mas usado por las inserciones y los benchmarks
+int buscarAVL(struct Node* raiz, int key) {
+    int visitados = 0;
+    while (raiz != NULL) {
+        visitados++;
+        if (key == raiz->key) {
+            AVL_CONTAR_BUSQUEDA(visitados);
+            return !nodoBorrado(raiz);  // Encontrado
+        }
+        raiz = (key < raiz->key) ? raiz->left : raiz->right;
+    }
+    AVL_CONTAR_BUSQUEDA(visitados);
+    return 0;  // No encontrado
+}
+
+// Buscar un valor en el arbol y devolver su profundidad
+/// pre: requiere un nodo, que es un puntero a una struct Node - valor: dato a buscar - nivel: nivel del arbol
+///post: Retorna el nivel en que esta valor (nivel de raiz + profundidad) - Retorna -1 si no esta
+int buscarConProfundidad(struct Node* raiz, int valor, int nivel) {
+    int visitados = 0;
+    while (raiz != NULL) {
+        visitados++;
+        if (valor == raiz->key) {
+            AVL_CONTAR_BUSQUEDA(visitados);
+            return nodoBorrado(raiz) ? -1 : nivel;  // Encontrado en este nivel
+        }
+        raiz = (valor < raiz->key) ? raiz->left : raiz->right;
+        nivel++;
+    }
+    AVL_CONTAR_BUSQUEDA(visitados);
+    return -1;  // No encontrado
+}
+
+/// pre: requiere un nodo, que es un puntero a una struct Node
+///post: Cuenta los nodos del arbol (uso de memoria), retorna la cant de nodo, retorna 0 si el nodo es NULL
+int contarNodos(struct Node* nodo) {
+    if (nodo == NULL) return 0;
+    return 1 + contarNodos(nodo->left) + contarNodos(nodo->right);
+}
+
+// Calcula la altura real del arbol
+/// pre: requiere un nodo, que es un puntero a una struct Node
+///post: retorna la altura del arbol, siendo este un valor entero
+int calcularAltura(struct Node* nodo) {
+    if (nodo == NULL) return 0;
+    int altIzq = calcularAltura(nodo->left);
+    int altDer = calcularAltura(nodo->right);
+    return 1 + (altIzq > altDer ? altIzq : altDer);
+}
+
+/// pre: Requiere un nodo raiz como parametro
+///post: Realiza el recorrido in order del AVL ( izquierda - raiz - derecha ) permitiendo imprimir el dato del arbon en orden ascendente
+void printInOrder(struct Node* node) {
+    if (node == NULL)
+        return;
+    printInOrder(node->left);
+    if (!nodoBorrado(node))
+        printf("%d ", node->key);
+    printInOrder(node->right);
+}
+
+// Funcion para liberar memoria del arbol AVL recursivamente
+void liberarArbol(struct Node* nodo) {
+    if (nodo == NULL) return;
+    liberarArbol(nodo->left);
+    liberarArbol(nodo->right);
+    liberarNodo(nodo);
+    AVL_CONTAR(liberaciones, 1);
+}
+
+/// pre: claves ordenadas en forma estrictamente creciente
+///post: Arma en O(n) un AVL perfectamente balanceado con las claves, tomando el medio como raiz
+///      de cada subarbol. Es la carga masiva: no hace comparaciones ni rotaciones
+struct Node* construirOrdenado(const int* claves, int cantidad) {
+    if (cantidad <= 0)
+        return NULL;
+    int medio = cantidad / 2;
+    struct Node* nodo = createNode(claves[medio]);
+    nodo->left = construirOrdenado(claves, medio);
+    nodo->right = construirOrdenado(claves + medio + 1, cantidad - medio - 1);
+    nodo->height = 1 + mayor(getHeight(nodo->left), getHeight(nodo->right));
+    return nodo;
+}
+
+// ---------------------------------- Partir y unir ----------------------------------
+// Unir dos AVL con todas las claves de uno menores que las del otro cuesta O(diferencia de alturas):
+// se baja por el borde del mas alto hasta un subarbol de la altura del otro, se cuelgan ahi y se
+// rebalancea al subir. Partir por una clave une los pedazos de cada lado del camino, y esas uniones
+// suman O(log n). Con eso quitar un rango entero cuesta O(log n) sin importar cuantas claves tenga.
+// Las alturas guardadas deben ser correctas: con balanceo relajado hay que drenar los pendientes antes.
+
+/// pre: nodo no es NULL y sus hijos son AVL con alturas que difieren a lo sumo en 2
+///post: Corrige la altura del nodo y rota si quedo desbalanceado. Retorna la nueva raiz del subarbol
+static struct Node* equilibrar(struct Node* nodo) {
+    nodo->height = 1 + mayor(getHeight(nodo->left), getHeight(nodo->right));
+    int balance = getBalanceFactor(nodo);
+
+    if (balance > 1) {
+        if (getBalanceFactor(nodo->left) < 0) {
+            nodo->left = leftRotate(nodo->left);
+            AVL_CONTAR(rotacionesDobles, 1);
+        } else {
+            AVL_CONTAR(rotacionesSimples, 1);
+        }
+        return rightRotate(nodo);
+    }
+    if (balance < -1) {
+        if (getBalanceFactor(nodo->right) > 0) {
+            nodo->right = rightRotate(nodo->right);
+            AVL_CONTAR(rotacionesDobles, 1);
+        } else {
+            AVL_CONTAR(rotacionesSimples, 1);
+        }
+        return leftRotate(nodo);
+    }
+    return nodo;
+}
+
+/// pre: izq y der son AVL (pueden ser NULL) - medio es un nodo suelto con una clave mayor que todas
+///      las de izq y menor que todas las de der
+///post: Retorna un AVL con las claves de los tres. Cuesta O(|altura(izq) - altura(der)| + 1)
+struct Node* unirAVL(struct Node* izq, struct Node* medio, struct Node* der) {
+    int alturaIzq = getHeight(izq);
+    int alturaDer = getHeight(der);
+
+    if (alturaIzq > alturaDer + 1) {
+        izq->right = unirAVL(izq->right, medio, der);
+        return equilibrar(izq);
+    }
+    if (alturaDer > alturaIzq + 1) {
+        der->left = unirAVL(izq, medio, der->left);
+        return equilibrar(der);
+    }
+    medio->left = izq;
+    medio->right = der;
+    medio->height = 1 + mayor(alturaIzq, alturaDer);
+    return medio;
+}
+
+/// pre: nodo no es NULL
+///post: Desengancha el nodo de clave minima en *minimo y retorna el resto rebalanceado
+static struct Node* quitarMinimo(struct Node* nodo, struct Node** minimo) {
+    if (nodo->left == NULL) {
+        *minimo = nodo;
+        return nodo->right;
+    }
+    nodo->left = quitarMinimo(nodo->left, minimo);
+    return equilibrar(nodo);
+}
+
+/// pre: izq y der son AVL y todas las claves de izq son menores que las de der
+///post: Retorna un AVL con las claves de ambos, usando el minimo de der como nodo del medio
+struct Node* concatenarAVL(struct Node* izq, struct Node* der) {
+    struct Node* medio;
+    if (der == NULL)
+        return izq;
+    der = quitarMinimo(der, &medio);
+    return unirAVL(izq, medio, der);
+}
+
+/// pre: raiz es un AVL - menores y resto no son NULL
+///post: Reparte los nodos de raiz en dos AVL: *menores con las claves < key y *resto con las >= key.
+///      No crea ni libera nodos; raiz deja de ser valida
+void partirAVL(struct Node* raiz, int key, struct Node** menores, struct Node** resto) {
+    struct Node* medio;
+    if (raiz == NULL) {
+        *menores = *resto = NULL;
+        return;
+    }
+    struct Node* izq = raiz->left;
+    struct Node* der = raiz->right;
+    if (key <= raiz->key) {
+        partirAVL(izq, key, menores, &medio);
+        *resto = unirAVL(medio, raiz, der);
+    } else {
+        partirAVL(der, key, &medio, resto);
+        *menores = unirAVL(izq, raiz, medio);
+    }
+}
+
+/// pre: *raiz es un AVL - desde <= hasta
+///post: Desengancha en O(log n) todas las claves de [desde, hasta] (tambien los nodos con borrado logico)
+///      y las retorna como un AVL propio; *raiz queda con el resto, balanceado. Quien llama libera lo extraido
+struct Node* extraerRango(struct Node** raiz, int desde, int hasta) {
+    struct Node *menores, *resto, *rango, *mayores;
+
+    partirAVL(*raiz, desde, &menores, &resto);
+    if (hasta == INT_MAX) {
+        rango = resto;
+        mayores = NULL;
+    } else {
+        partirAVL(resto, hasta + 1, &rango, &mayores);
+    }
+    *raiz = concatenarAVL(menores, mayores);
+    return rango;
+}
+
+
+// ---------------------------------- Contadores de estructura ----------------------------------
+
+#if AVL_CONTADORES
+AVL_POR_HILO struct ContadoresAVL* avlContadoresPropias = NULL;
+static struct ContadoresAVL* volatile listaContadores = NULL;    // Un bloque por hilo que conto algo
+
+/// pre: El hilo todavia no tiene bloque
+///post: Crea el bloque del hilo en 0, lo enlaza en la lista global y lo retorna
+struct ContadoresAVL* avlContadoresRegistrar(void) {
+    struct ContadoresAVL* e = (struct ContadoresAVL*)calloc(1, sizeof(struct ContadoresAVL));
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    do {
+        e->siguiente = listaContadores;
+    } while (InterlockedCompareExchangePointer((PVOID volatile*)&listaContadores, e, e->siguiente) != e->siguiente);
+#else
+    e->siguiente = listaContadores;
+    listaContadores = e;
+#endif
+    avlContadoresPropias = e;
+    return e;
+}
+#endif
+
+/// pre: total no es NULL
+///post: Deja en total la suma de los bloques de todos los hilos (el nivel maximo es el mayor de todos).
+///      Con hilos contando a la vez la suma es aproximada. Sin AVL_CONTADORES deja todo en 0
+void avlContadoresSumar(struct ContadoresAVL* total) {
+    struct ContadoresAVL vacio = {0};
+    *total = vacio;
+#if AVL_CONTADORES
+    for (struct ContadoresAVL* e = listaContadores; e != NULL; e = e->siguiente) {
+        total->rotacionesSimples += e->rotacionesSimples;
+        total->rotacionesDobles += e->rotacionesDobles;
+        total->busquedas += e->busquedas;
+        total->nodosVisitados += e->nodosVisitados;
+        total->rebalanceos += e->rebalanceos;
+        total->nivelesRebalanceo += e->nivelesRebalanceo;
+        if (e->nivelMaximoRebalanceo > total->nivelMaximoRebalanceo)
+            total->nivelMaximoRebalanceo = e->nivelMaximoRebalanceo;
+        total->reintentos += e->reintentos;
+        total->reservas += e->reservas;
+        total->liberaciones += e->liberaciones;
+    }
+#endif
+}
+
+/// pre: Conviene que ningun hilo este contando (si no, puede quedar algo de antes)
+///post: Pone en 0 los contadores de todos los hilos
+void avlContadoresReiniciar(void) {
+#if AVL_CONTADORES
+    for (struct ContadoresAVL* e = listaContadores; e != NULL; e = e->siguiente) {
+        struct ContadoresAVL* siguiente = e->siguiente;
+        struct ContadoresAVL vacio = {0};
+        *e = vacio;
+        e->siguiente = siguiente;
+    }
+#endif
+}
+
+
+// ---------------------------------- Liberacion diferida ----------------------------------
+// Los subarboles desenganchados se apilan en la papelera y se liberan despues, de a tandas, fuera del
+// bloqueo del arbol. Se guarda un solo arbol binario (sin orden) con todo lo pendiente: agregar cuelga
+// lo que habia del borde derecho del subarbol nuevo, y liberar rota a derecha mientras haya hijo
+// izquierdo y si no libera la raiz, sin pila ni recursion.
+
+/// pre: papelera sin inicializar
+///post: Papelera vacia
+void papeleraInicializar(struct PapeleraAVL* papelera) {
+    papelera->pendientes = NULL;
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    InitializeSRWLock(&papelera->lock);
+#endif
+}
+
+/// pre: subarbol es un AVL desenganchado que nadie mas lee
+///post: Lo deja pendiente de liberar. Cuesta O(altura del subarbol): no cuenta ni recorre sus nodos
+void papeleraAgregar(struct PapeleraAVL* papelera, struct Node* subarbol) {
+    if (subarbol == NULL)
+        return;
+    struct Node* ultimo = subarbol;
+    while (ultimo->right != NULL)
+        ultimo = ultimo->right;
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    AcquireSRWLockExclusive(&papelera->lock);
+#endif
+    ultimo->right = papelera->pendientes;
+    papelera->pendientes = subarbol;
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    ReleaseSRWLockExclusive(&papelera->lock);
+#endif
+}
+
+/// pre: papelera inicializada - maximo: nodos a liberar como mucho (0: todos)
+///post: Libera nodos pendientes y retorna cuantos libero. Solo bloquea a otros que agreguen o liberen
+long long papeleraLiberar(struct PapeleraAVL* papelera, long long maximo) {
+    long long liberados = 0;
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    AcquireSRWLockExclusive(&papelera->lock);
+#endif
+    struct Node* nodo = papelera->pendientes;
+    while (nodo != NULL && (maximo == 0 || liberados < maximo)) {
+        if (nodo->left != NULL) {           // Rotacion a derecha: el hijo izquierdo sube
+            struct Node* izq = nodo->left;
+            nodo->left = izq->right;
+            izq->right = nodo;
+            nodo = izq;
+        } else {
+            struct Node* der = nodo->right;
+            liberarNodo(nodo);
+            nodo = der;
+            liberados++;
+        }
+    }
+    papelera->pendientes = nodo;
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    ReleaseSRWLockExclusive(&papelera->lock);
+#endif
+    AVL_CONTAR(liberaciones, liberados);
+    return liberados;
+}
+
+// ---------------------------------- Dedo ----------------------------------
+
+/// pre:
+///post: Deja el dedo vacio: la proxima operacion empieza desde la raiz
+void dedoReiniciar(struct DedoAVL* dedo) {
+    dedo->profundidad = 0;
+}
+
+/// pre: Desde que se reinicio el dedo, el arbol de raiz solo cambio por operaciones con este dedo
+///post: Sube por el camino guardado hasta el primer subarbol cuyo rango contiene key y baja desde ahi
+///      guardando el camino. Retorna la profundidad del enlace donde esta key o donde iria (NULL)
+static int ubicarConDedo(struct DedoAVL* dedo, struct Node** raiz, int key) {
+    if (dedo->profundidad == 0 || dedo->enlaces[0] != raiz) {
+        dedo->enlaces[0] = raiz;
+        dedo->desde[0] = LLONG_MIN;
+        dedo->hasta[0] = LLONG_MAX;
+        dedo->profundidad = 1;
+    }
+
+    int i = dedo->profundidad - 1;
+    while (i > 0 && !(dedo->desde[i] < key && key < dedo->hasta[i]))
+        i--;
+
+    struct Node* nodo = *dedo->enlaces[i];
+    while (nodo != NULL && nodo->key != key && i + 1 < AVL_ALTURA_MAXIMA) {
+        if (key < nodo->key) {
+            dedo->enlaces[i + 1] = &nodo->left;
+            dedo->desde[i + 1] = dedo->desde[i];
+            dedo->hasta[i + 1] = nodo->key;
+        } else {
+            dedo->enlaces[i + 1] = &nodo->right;
+            dedo->desde[i + 1] = nodo->key;
+            dedo->hasta[i + 1] = dedo->hasta[i];
+        }
+        i++;
+        nodo = *dedo->enlaces[i];
+    }
+    dedo->profundidad = i + 1;
+    return i;
+}
+
+/// pre: Desde que se reinicio el dedo, el arbol de raiz solo cambio por operaciones con este dedo
+///post: Inserta key partiendo del dedo y deja el dedo en el nodo nuevo. Rebalancea hacia arriba solo
+///      hasta el primer ancestro que no cambia de altura o rota, como insert. Agregar por encima del
+///      maximo es el mejor caso: el dedo queda al final de la espina derecha, cuyo rango no tiene tope,
+///      y la siguiente clave mayor se engancha sin subir. Retorna 1 si se inserto, 0 si ya estaba
+int insertarConDedo(struct DedoAVL* dedo, struct Node** raiz, int key) {
+    int i = ubicarConDedo(dedo, raiz, key);
+    if (*dedo->enlaces[i] != NULL)
+        return revivirNodo(*dedo->enlaces[i]);  // No se permiten duplicados, salvo un borrado logico
+
+    *dedo->enlaces[i] = createNode(key);
+    AVL_CONTAR_REBALANCEO();
+    for (int j = i - 1; j >= 0; j--) {
+        struct Node* nodo = *dedo->enlaces[j];
+        int alturaPrevia = nodo->height;
+        *dedo->enlaces[j] = rebalancearInsercion(nodo, key);
+        AVL_CONTAR_NIVEL_SI(*dedo->enlaces[j] != nodo || nodo->height != alturaPrevia);
+        if (*dedo->enlaces[j] != nodo) {
+            // La rotacion cambio el subarbol: su enlace y su rango siguen valiendo, lo de abajo no
+            dedo->profundidad = j + 1;
+            break;
+        }
+        if (nodo->height == alturaPrevia)
+            break;
+    }
+    return 1;
+}
+
+/// pre: Desde que se reinicio el dedo, el arbol de raiz solo cambio por operaciones con este dedo
+///post: Busca key partiendo del dedo y lo deja en el lugar de key. Retorna 1 si esta (y no esta borrada)
+int buscarConDedo(struct DedoAVL* dedo, struct Node** raiz, int key) {
+    int i = ubicarConDedo(dedo, raiz, key);
+    struct Node* nodo = *dedo->enlaces[i];
+    return nodo != NULL && nodo->key == key && !nodoBorrado(nodo);
+}
+
+
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+// ---------------------------------- Cerrojo de la politica mutex ----------------------------------
+
+/// pre: cerrojo sin inicializar
+///post: Deja el cerrojo libre en modo giro y crea tambien el mutex del sistema para poder elegirlo
+void cerrojoInicializar(struct CerrojoAVL* cerrojo) {
+    SYSTEM_INFO sistema;
+
+    GetSystemInfo(&sistema);
+    cerrojo->siguiente = 0;
+    cerrojo->atendiendo = 0;
+    cerrojo->dormidos = 0;
+    cerrojo->pausasMaximas = sistema.dwNumberOfProcessors > 1 ? CERROJO_PAUSAS_MAXIMAS : 0;
+    cerrojo->modo = CERROJO_GIRO;
+    cerrojo->mutex = CreateMutex(NULL, FALSE, NULL);
+    for (int i = 0; i < CERROJO_RANURAS; i++)
+        cerrojo->avisos[i] = 0;
+}
+
+/// pre: Nadie tiene ni espera el cerrojo
+///post: Libera el mutex del sistema
+void cerrojoDestruir(struct CerrojoAVL* cerrojo) {
+    CloseHandle(cerrojo->mutex);
+}
+
+/// pre: Nadie tiene ni espera el cerrojo - modo es CERROJO_SISTEMA o CERROJO_GIRO
+///post: Las proximas tomas usan el modo elegido
+void cerrojoElegirModo(struct CerrojoAVL* cerrojo, int modo) {
+    cerrojo->modo = modo;
+}
+
+/// pre: turno fue sacado de cerrojo->siguiente y todavia no es el atendido
+///post: Retorna cuando el turno atendido es turno. Gira con una pausa que se duplica en cada vuelta y
+///      se multiplica por los turnos de delante (cada uno es una seccion critica entera); gastadas
+///      pausasMaximas pausas duerme en la ranura de su turno hasta que quien suelta la cambie
+void cerrojoEsperarTurno(struct CerrojoAVL* cerrojo, LONG turno) {
+    volatile LONG* aviso = &cerrojo->avisos[(ULONG)turno & (CERROJO_RANURAS - 1)];
+    LONG pausa = 8;
+    LONG pausadas = 0;
+    LONG visto;
+
+    while ((visto = cerrojo->atendiendo) != turno) {
+        if (pausadas < cerrojo->pausasMaximas) {
+            LONG delante = turno - visto;       // Resta con desborde: los turnos dan la vuelta
+            LONG vuelta = delante < 1024 / pausa ? pausa * delante : 1024;
+            for (LONG p = 0; p < vuelta; p++)
+                YieldProcessor();
+            pausadas += vuelta;
+            if (pausa < 256)
+                pausa *= 2;
+        } else {
+            // El aviso se lee antes de anotarse como dormido: si quien suelta nuestro turno no vio
+            // dormidos, nosotros si vemos el turno al volver a mirar, y si lo vio cambia el aviso
+            LONG leido = *aviso;
+            InterlockedIncrement(&cerrojo->dormidos);
+            if (cerrojo->atendiendo != turno)
+                WaitOnAddress(aviso, &leido, sizeof(LONG), INFINITE);   // Vuelve ya si el aviso cambio
+            InterlockedDecrement(&cerrojo->dormidos);
+        }
+    }
+}
+#endif
+
+
+// ---------------------------------- Arbol con politica de sincronizacion ----------------------------------
+
+/// pre: arbol sin inicializar
+///post: Deja el arbol vacio y crea su bloqueo segun AVL_SINCRONIZACION
+void avlInicializar(struct ArbolAVL* arbol) {
+    arbol->raiz = NULL;
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoInicializar(&arbol->cerrojo);
+#elif AVL_SINCRONIZACION == AVL_SINC_LECTOR_ESCRITOR
+    InitializeSRWLock(&arbol->lock);
+#elif AVL_SINCRONIZACION == AVL_SINC_FINA
+    InitializeSRWLock(&arbol->lock);
+    InitializeSRWLock(&arbol->lockRaiz);
+#endif
+}
+
+/// pre: Ningun hilo usa el arbol
+///post: Libera todos los nodos y el bloqueo
+void avlDestruir(struct ArbolAVL* arbol) {
+    liberarArbol(arbol->raiz);
+    arbol->raiz = NULL;
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoDestruir(&arbol->cerrojo);
+#endif
+}
+
+#if AVL_SINCRONIZACION == AVL_SINC_FINA
+/// pre: bloqueados contiene b locks exclusivos tomados
+///post: Los suelta todos
+static void soltarBloqueos(SRWLOCK** bloqueados, int b) {
+    for (int i = 0; i < b; i++)
+        ReleaseSRWLockExclusive(bloqueados[i]);
+}
+
+/// pre: Debe tenerse arbol->lock compartido
+///post: Inserta key bajando con bloqueo acoplado (lock coupling). Al insertar en un AVL solo cambia la
+///      altura de los nodos por debajo del ultimo nodo del camino con balance distinto de 0 (el nodo
+///      critico), y la unica rotacion posible es en el. Por eso al encontrar un nodo critico se sueltan
+///      todos los nodos de arriba salvo su padre, cuyo enlace puede cambiar. Retorna 1 si se inserto
+static int insertarFino(struct ArbolAVL* arbol, int key) {
+    struct Node** enlaces[AVL_ALTURA_MAXIMA];   // Donde cuelga cada nodo del camino
+    struct Node* nodos[AVL_ALTURA_MAXIMA];
+    SRWLOCK* bloqueados[AVL_ALTURA_MAXIMA + 1];
+    struct Node** enlace = &arbol->raiz;
+    int n = 0, b = 0, critico = 0;
+
+    AcquireSRWLockExclusive(&arbol->lockRaiz);
+    bloqueados[b++] = &arbol->lockRaiz;
+
+    while (*enlace != NULL) {
+        struct Node* nodo = *enlace;
+        AcquireSRWLockExclusive(&nodo->lock);
+
+        if (key == nodo->key) {
+            int revivido = revivirNodo(nodo);   // Un borrado logico se deshace sin tocar la forma
+            ReleaseSRWLockExclusive(&nodo->lock);
+            soltarBloqueos(bloqueados, b);
+            return revivido; // No se permiten duplicados
+        }
+
+        // Con el nodo tomado las alturas de sus hijos no cambian: quien las cambia retiene este nodo
+        if (getBalanceFactor(nodo) != 0) {
+            soltarBloqueos(bloqueados, b - 1);      // Se conserva solo el lock del enlace al nodo
+            bloqueados[0] = bloqueados[b - 1];
+            b = 1;
+            critico = n;
+        }
+
+        bloqueados[b++] = &nodo->lock;
+        enlaces[n] = enlace;
+        nodos[n++] = nodo;
+        enlace = (key < nodo->key) ? &nodo->left : &nodo->right;
+    }
+
+    *enlace = createNode(key);
+    AVL_CONTAR_REBALANCEO();
+
+    // Rebalancea de abajo hacia arriba hasta el nodo critico (todos los del tramo estan tomados)
+    for (int i = n - 1; i >= critico; i--) {
+        int alturaPrevia = nodos[i]->height;
+        *enlaces[i] = rebalancearInsercion(nodos[i], key);
+        AVL_CONTAR_NIVEL_SI(*enlaces[i] != nodos[i] || nodos[i]->height != alturaPrevia);
+    }
+
+    soltarBloqueos(bloqueados, b);
+    return 1;
+}
+
+/// pre: Debe tenerse arbol->lock compartido
+///post: Busca key bajando con locks compartidos, soltando cada nodo al tomar el siguiente
+static int buscarFino(struct ArbolAVL* arbol, int key) {
+    SRWLOCK* anterior = &arbol->lockRaiz;
+    struct Node* nodo;
+    int encontrado = 0;
+    int visitados = 0;
+
+    AcquireSRWLockShared(anterior);
+    nodo = arbol->raiz;
+    while (nodo != NULL) {
+        AcquireSRWLockShared(&nodo->lock);
+        ReleaseSRWLockShared(anterior);
+        anterior = &nodo->lock;
+        visitados++;
+        if (key == nodo->key) {
+            encontrado = !nodoBorrado(nodo);
+            break;
+        }
+        nodo = (key < nodo->key) ? nodo->left : nodo->right;
+    }
+    ReleaseSRWLockShared(anterior);
+    AVL_CONTAR_BUSQUEDA(visitados);
+    return encontrado;
+}
+#endif
+
+/// pre: arbol inicializado - key: dato a insertar
+///post: Inserta key tomando el bloqueo que indique la politica. Retorna 1 si se inserto, 0 si ya estaba
+int avlInsertar(struct ArbolAVL* arbol, int key) {
+#if AVL_SINCRONIZACION == AVL_SINC_FINA
+    AcquireSRWLockShared(&arbol->lock);         // Solo excluye borrados y recorridos completos
+    int insertado = insertarFino(arbol, key);
+    ReleaseSRWLockShared(&arbol->lock);
+    return insertado;
+#else
+    int insertado = 0;
+    avlBloquearEscritura(arbol);
+    if (!buscarAVL(arbol->raiz, key)) {     // Solo insertamos dato  no existe
+        arbol->raiz = insert(arbol->raiz, key);
+        insertado = 1;
+    }
+    avlLiberarEscritura(arbol);
+    return insertado;
+#endif
+}
+
+/// pre: arbol inicializado - key: dato a eliminar
+///post: Elimina key con el arbol tomado en forma exclusiva (el borrado puede rotar en todo el camino).
+///      Retorna 1 si existia, 0 si no
+int avlEliminar(struct ArbolAVL* arbol, int key) {
+    avlBloquearEscritura(arbol);
+    int existe = buscarAVL(arbol->raiz, key);
+    if (existe)
+        arbol->raiz = deleteNode(arbol->raiz, key);
+    avlLiberarEscritura(arbol);
+    return existe;
+}
+
+/// pre: arbol inicializado - key: dato a buscar
+///post: Retorna 1 si key esta en el arbol, 0 si no
+int avlContiene(struct ArbolAVL* arbol, int key) {
+#if AVL_SINCRONIZACION == AVL_SINC_FINA
+    AcquireSRWLockShared(&arbol->lock);
+    int encontrado = buscarFino(arbol, key);
+    ReleaseSRWLockShared(&arbol->lock);
+    return encontrado;
+#else
+    avlBloquearLectura(arbol);
+    int encontrado = buscarAVL(arbol->raiz, key);
+    avlLiberarLectura(arbol);
+    return encontrado;
+#endif
+}
+
+/// pre: arbol inicializado - desde <= hasta
+///post: Desengancha las claves de [desde, hasta] con el arbol tomado en forma exclusiva solo O(log n),
+///      y las retorna como un AVL propio que quien llama debe liberar
+struct Node* avlExtraerRango(struct ArbolAVL* arbol, int desde, int hasta) {
+    avlBloquearEscritura(arbol);
+    struct Node* rango = extraerRango(&arbol->raiz, desde, hasta);
+    avlLiberarEscritura(arbol);
+    return rango;
+}
+
+/// pre: arbol y papelera inicializados - desde <= hasta
+///post: Quita las claves de [desde, hasta] y deja sus nodos en la papelera: la liberacion, que es lo
+///      que cuesta O(k), la hace despues quien llame a papeleraLiberar. Retorna 1 si quito algun nodo
+int avlEliminarRango(struct ArbolAVL* arbol, struct PapeleraAVL* papelera, int desde, int hasta) {
+    struct Node* rango = avlExtraerRango(arbol, desde, hasta);
+    papeleraAgregar(papelera, rango);       // Fuera del bloqueo del arbol
+    return rango != NULL;
+}
+
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+/// pre: arbol inicializado - key: dato a eliminar
+///post: Borrado logico: marca el nodo de key sin desengancharlo ni rotar, con el bloqueo de una busqueda.
+///      Quien lo quite del arbol (deleteNode) debe tener el arbol en escritura. Retorna 1 si key estaba
+int avlMarcarBorrado(struct ArbolAVL* arbol, int key) {
+    int marcado = 0;
+#if AVL_SINCRONIZACION == AVL_SINC_FINA
+    SRWLOCK* anterior = &arbol->lockRaiz;
+    struct Node* nodo;
+
+    AcquireSRWLockShared(&arbol->lock);
+    AcquireSRWLockShared(anterior);
+    nodo = arbol->raiz;
+    while (nodo != NULL) {
+        AcquireSRWLockShared(&nodo->lock);
+        ReleaseSRWLockShared(anterior);
+        anterior = &nodo->lock;
+        if (key == nodo->key) {
+            // Con el nodo compartido solo compiten otros borrados: la insercion que revive lo toma exclusivo
+            marcado = InterlockedExchange(&nodo->borrado, 1) == 0;
+            break;
+        }
+        nodo = (key < nodo->key) ? nodo->left : nodo->right;
+    }
+    ReleaseSRWLockShared(anterior);
+    ReleaseSRWLockShared(&arbol->lock);
+#else
+    avlBloquearLectura(arbol);
+    struct Node* nodo = arbol->raiz;
+    while (nodo != NULL && nodo->key != key)
+        nodo = (key < nodo->key) ? nodo->left : nodo->right;
+    if (nodo != NULL)
+        marcado = InterlockedExchange(&nodo->borrado, 1) == 0;
+    avlLiberarLectura(arbol);
+#endif
+    return marcado;
+}
+#endif
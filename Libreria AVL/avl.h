@@ -0,0 +1,339 @@
+#ifndef AVL_H
+#define AVL_H
+
+// ---------------------------------- Libreria AVL ----------------------------------
+// Nucleo del arbol AVL compartido por la version secuencial y la concurrente.
+// La politica de sincronizacion se elige al compilar con AVL_SINCRONIZACION (por ejemplo
+// -DAVL_SINCRONIZACION=AVL_SINC_FINA en las opciones del proyecto). Debe ser la misma para
+// avl.c y para el programa que lo usa.
+//
+//   AVL_SINC_NINGUNA         Sin bloqueos: las funciones de bloqueo no generan codigo (secuencial)
+//   AVL_SINC_MUTEX           Un cerrojo para todo el arbol: de turnos en espacio de usuario (gira,
+//                            luego duerme con WaitOnAddress) o el mutex del sistema, a eleccion
+//   AVL_SINC_LECTOR_ESCRITOR SRWLOCK: busquedas y recorridos en paralelo, escrituras exclusivas
+//   AVL_SINC_FINA            Un SRWLOCK por nodo: las inserciones solo retienen el tramo del camino
+//                            que pueden rotar, las busquedas bajan soltando el nodo anterior
+
+#define AVL_SINC_NINGUNA 0
+#define AVL_SINC_MUTEX 1
+#define AVL_SINC_LECTOR_ESCRITOR 2
+#define AVL_SINC_FINA 3
+
+#ifndef AVL_SINCRONIZACION
+#define AVL_SINCRONIZACION AVL_SINC_NINGUNA
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "memoria.h"    // Los nodos se piden y devuelven contados (MEMORIA_AVL)
+
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602     // Windows 8 o posterior: SRWLOCK y WaitOnAddress
+#endif
+#include <windows.h>
+#endif
+
+#define AVL_ALTURA_MAXIMA 64    // Un AVL de 2^31 nodos no supera altura 45
+
+// Estructura del Nodo arbol AVL
+// key: representa el dato.
+// posee un puntero a sus hijos, siendo otro nodo, izq y derecho
+// height: representa la altura, y permite calcular el balance del arbol
+/// Estructura NODO - key y height juntos para que el nodo secuencial ocupe 24 bytes en 64 bits
+struct Node {
+    int key;
+    int height;
+    struct Node* left;
+    struct Node* right;
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    volatile LONG refs;     // Modo persistente: cantidad de padres (nodos o versiones) que lo comparten
+    volatile LONG borrado;  // Borrado logico: el nodo sigue enlazado pero la clave no esta (ocupa el relleno tras refs)
+#endif
+#if AVL_SINCRONIZACION == AVL_SINC_FINA
+    SRWLOCK lock;           // Protege los campos del nodo en la politica fina
+#endif
+};
+
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+// ---------------------------------- Cerrojo de la politica mutex ----------------------------------
+// Las secciones criticas del arbol duran unos cientos de nanosegundos y el mutex del sistema es un
+// objeto del kernel: tomarlo y soltarlo son llamadas al sistema aunque nadie compita. El cerrojo de
+// turnos resuelve el caso sin contencion con una instruccion atomica para tomar y otra para soltar.
+// Con contencion cada hilo saca un turno y gira esperandolo, con una pausa que crece en cada vuelta;
+// gastadas CERROJO_PAUSAS_MAXIMAS pausas (decenas de microsegundos) se duerme con WaitOnAddress en la
+// ranura de su turno. Soltar llama al sistema solo si alguien duerme, y despierta solo la ranura del
+// turno siguiente. Los turnos dan orden de llegada: nadie espera indefinidamente.
+// Se enlaza con Synchronization.lib (WaitOnAddress)
+
+#define CERROJO_SISTEMA 0       // Mutex del kernel (CreateMutex), como antes
+#define CERROJO_GIRO 1          // Turnos en espacio de usuario: gira y despues duerme
+#define CERROJO_PAUSAS_MAXIMAS 8192
+#define CERROJO_RANURAS 64      // Potencia de 2: el turno t duerme en avisos[t % CERROJO_RANURAS]
+#define CERROJO_LINEA_CACHE 64
+
+struct CerrojoAVL {
+    volatile LONG siguiente;    // Proximo turno a entregar: lo escriben los que llegan
+    char relleno[CERROJO_LINEA_CACHE - sizeof(LONG)];   // Los que llegan no invalidan la linea de los que giran
+    volatile LONG atendiendo;   // Turno que tiene el cerrojo: solo lo escribe quien suelta
+    volatile LONG dormidos;     // Hilos en WaitOnAddress: si es 0, soltar no llama al sistema
+    int pausasMaximas;          // 0 con un solo procesador: girar solo demora a quien tiene el cerrojo
+    int modo;                   // CERROJO_SISTEMA o CERROJO_GIRO
+    HANDLE mutex;
+    volatile LONG avisos[CERROJO_RANURAS];  // Cambian al atender su turno: ahi duermen los que esperan
+};
+
+void cerrojoInicializar(struct CerrojoAVL* cerrojo);
+void cerrojoDestruir(struct CerrojoAVL* cerrojo);
+void cerrojoElegirModo(struct CerrojoAVL* cerrojo, int modo);
+void cerrojoEsperarTurno(struct CerrojoAVL* cerrojo, LONG turno);
+
+/// pre: cerrojo inicializado
+///post: Toma el cerrojo. Sin contencion en modo giro no sale del espacio de usuario
+static inline void cerrojoTomar(struct CerrojoAVL* cerrojo) {
+    if (cerrojo->modo == CERROJO_GIRO) {
+        LONG turno = InterlockedExchangeAdd(&cerrojo->siguiente, 1);
+        if (cerrojo->atendiendo != turno)
+            cerrojoEsperarTurno(cerrojo, turno);
+    } else {
+        WaitForSingleObject(cerrojo->mutex, INFINITE);
+    }
+}
+
+/// pre: Quien llama tiene el cerrojo
+///post: Pasa el cerrojo al turno siguiente y lo despierta si estaba dormido
+static inline void cerrojoSoltar(struct CerrojoAVL* cerrojo) {
+    if (cerrojo->modo == CERROJO_GIRO) {
+        LONG turno = InterlockedIncrement(&cerrojo->atendiendo);    // Barrera completa: se lee dormidos despues
+        if (cerrojo->dormidos != 0) {
+            volatile LONG* aviso = &cerrojo->avisos[(ULONG)turno & (CERROJO_RANURAS - 1)];
+            InterlockedIncrement(aviso);
+            WakeByAddressAll((PVOID)aviso);     // Solo duermen ahi los turnos congruentes: casi siempre uno
+        }
+    } else {
+        ReleaseMutex(cerrojo->mutex);
+    }
+}
+#endif
+
+// Arbol con su bloqueo segun la politica elegida
+struct ArbolAVL {
+    struct Node* raiz;
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    struct CerrojoAVL cerrojo;
+#elif AVL_SINCRONIZACION == AVL_SINC_LECTOR_ESCRITOR
+    SRWLOCK lock;
+#elif AVL_SINCRONIZACION == AVL_SINC_FINA
+    SRWLOCK lock;           // Compartido: operaciones por nodo - Exclusivo: borrados y recorridos completos
+    SRWLOCK lockRaiz;       // Protege el puntero raiz como si fuera el enlace de un padre
+#endif
+};
+
+// Dedo: camino guardado desde la raiz hasta el ultimo lugar donde se inserto o busco. Cada entrada es
+// el enlace a un subarbol y el rango abierto (desde, hasta) de claves que ese subarbol puede tener.
+// Una clave cerca de la anterior se ubica subiendo por el camino hasta el primer rango que la contiene
+// y bajando desde ahi: O(log d), con d la distancia en claves, en lugar de O(log n) desde la raiz
+struct DedoAVL {
+    struct Node** enlaces[AVL_ALTURA_MAXIMA];
+    long long desde[AVL_ALTURA_MAXIMA];
+    long long hasta[AVL_ALTURA_MAXIMA];
+    int profundidad;        // Entradas validas - 0: vacio, se empieza desde la raiz
+};
+
+// Papelera: subarboles ya desenganchados que esperan ser liberados fuera del bloqueo del arbol
+// (ver papeleraAgregar y papeleraLiberar en avl.c)
+struct PapeleraAVL {
+    struct Node* pendientes;    // Todo lo pendiente como un solo arbol binario, sin orden de claves
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    SRWLOCK lock;
+#endif
+};
+
+// ---------------------------------- Contadores de estructura ----------------------------------
+// Con -DAVL_CONTADORES=1 (en avl.c y en el programa) cada hilo cuenta en su propio bloque, sin
+// atomicos ni lineas de cache compartidas: rotaciones, nodos visitados por busqueda, cuantos ancestros
+// cambio cada rebalanceo, reintentos de insercion y nodos reservados y liberados. El bloque se enlaza en
+// una lista global la primera vez que el hilo cuenta y no se libera (los hilos que terminan siguen
+// sumando). Sin la opcion las macros AVL_CONTAR... no generan codigo y el bloque queda en 0.
+
+#ifndef AVL_CONTADORES
+#define AVL_CONTADORES 0
+#endif
+
+struct ContadoresAVL {
+    long long rotacionesSimples;
+    long long rotacionesDobles;
+    long long busquedas;            // buscarAVL, buscarConProfundidad y la busqueda fina
+    long long nodosVisitados;       // Nodos mirados por esas busquedas
+    long long rebalanceos;          // Inserciones y borrados que cambiaron la forma del arbol
+    long long nivelesRebalanceo;    // Ancestros que cambiaron de altura o rotaron, sumados
+    long long nivelMaximoRebalanceo;
+    long long nivelActual;          // Ancestros del rebalanceo en curso
+    long long reintentos;           // Vueltas del bucle de insercion que no insertaron (clave repetida)
+    long long reservas;             // Nodos creados
+    long long liberaciones;         // Nodos liberados
+    struct ContadoresAVL* siguiente;
+};
+
+void avlContadoresSumar(struct ContadoresAVL* total);
+void avlContadoresReiniciar(void);
+
+#if AVL_CONTADORES
+#ifdef _MSC_VER
+#define AVL_POR_HILO __declspec(thread)
+#else
+#define AVL_POR_HILO __thread
+#endif
+
+extern AVL_POR_HILO struct ContadoresAVL* avlContadoresPropias;
+struct ContadoresAVL* avlContadoresRegistrar(void);
+
+/// pre:
+///post: Retorna el bloque de contadores del hilo que llama, creandolo la primera vez
+static inline struct ContadoresAVL* avlContadoresHilo(void) {
+    struct ContadoresAVL* e = avlContadoresPropias;
+    return e != NULL ? e : avlContadoresRegistrar();
+}
+
+/// pre: visitados: nodos mirados por una busqueda
+///post: Cuenta la busqueda y sus nodos
+static inline void avlContarBusqueda(int visitados) {
+    struct ContadoresAVL* e = avlContadoresHilo();
+    e->busquedas++;
+    e->nodosVisitados += visitados;
+}
+
+/// pre: Se creo o libero el nodo que empieza un cambio de forma
+///post: Cuenta un rebalanceo nuevo: los ancestros que cambien se suman a el
+static inline void avlContarRebalanceo(void) {
+    struct ContadoresAVL* e = avlContadoresHilo();
+    e->rebalanceos++;
+    e->nivelActual = 0;
+}
+
+/// pre:
+///post: Un ancestro mas cambio en el rebalanceo en curso
+static inline void avlContarNivel(void) {
+    struct ContadoresAVL* e = avlContadoresHilo();
+    e->nivelesRebalanceo++;
+    if (++e->nivelActual > e->nivelMaximoRebalanceo)
+        e->nivelMaximoRebalanceo = e->nivelActual;
+}
+
+#define AVL_CONTAR(campo, n) (avlContadoresHilo()->campo += (n))
+#define AVL_CONTAR_BUSQUEDA(visitados) avlContarBusqueda(visitados)
+#define AVL_CONTAR_REBALANCEO() avlContarRebalanceo()
+#define AVL_CONTAR_NIVEL_SI(condicion) ((condicion) ? avlContarNivel() : (void)0)
+#else
+// sizeof no evalua: los argumentos no generan codigo pero siguen "usados" para el compilador
+#define AVL_CONTAR(campo, n) ((void)sizeof(n))
+#define AVL_CONTAR_BUSQUEDA(visitados) ((void)sizeof(visitados))
+#define AVL_CONTAR_REBALANCEO() ((void)0)
+#define AVL_CONTAR_NIVEL_SI(condicion) ((void)sizeof(condicion))
+#endif
+
+// ---------------------------------- Funciones del AVL (sin bloqueos) ----------------------------------
+int getHeight(struct Node* n);
+int mayor(int a, int b);
+struct Node* createNode(int key);
+void liberarNodo(struct Node* nodo);
+int getBalanceFactor(struct Node* n);
+struct Node* rightRotate(struct Node* y);
+struct Node* leftRotate(struct Node* x);
+struct Node* insert(struct Node* node, int key);
+struct Node* minValueNode(struct Node* node);
+struct Node* deleteNode(struct Node* root, int key);
+int buscarAVL(struct Node* raiz, int key);
+int buscarConProfundidad(struct Node* raiz, int valor, int nivel);
+int contarNodos(struct Node* nodo);
+int calcularAltura(struct Node* nodo);
+void printInOrder(struct Node* node);
+void liberarArbol(struct Node* nodo);
+struct Node* construirOrdenado(const int* claves, int cantidad);
+struct Node* unirAVL(struct Node* izq, struct Node* medio, struct Node* der);
+struct Node* concatenarAVL(struct Node* izq, struct Node* der);
+void partirAVL(struct Node* raiz, int key, struct Node** menores, struct Node** resto);
+struct Node* extraerRango(struct Node** raiz, int desde, int hasta);
+void papeleraInicializar(struct PapeleraAVL* papelera);
+void papeleraAgregar(struct PapeleraAVL* papelera, struct Node* subarbol);
+long long papeleraLiberar(struct PapeleraAVL* papelera, long long maximo);
+void dedoReiniciar(struct DedoAVL* dedo);
+int insertarConDedo(struct DedoAVL* dedo, struct Node** raiz, int key);
+int buscarConDedo(struct DedoAVL* dedo, struct Node** raiz, int key);
+
+// ---------------------------------- Arbol con politica de sincronizacion ----------------------------------
+void avlInicializar(struct ArbolAVL* arbol);
+void avlDestruir(struct ArbolAVL* arbol);
+int avlInsertar(struct ArbolAVL* arbol, int key);
+int avlEliminar(struct ArbolAVL* arbol, int key);
+int avlContiene(struct ArbolAVL* arbol, int key);
+struct Node* avlExtraerRango(struct ArbolAVL* arbol, int desde, int hasta);
+int avlEliminarRango(struct ArbolAVL* arbol, struct PapeleraAVL* papelera, int desde, int hasta);
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+int avlMarcarBorrado(struct ArbolAVL* arbol, int key);
+#endif
+
+/// pre: n no es NULL
+///post: Retorna 1 si n tiene la marca de borrado logico (busquedas y recorridos lo tratan como ausente)
+static inline int nodoBorrado(struct Node* n) {
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    return n->borrado != 0;
+#else
+    (void)n;
+    return 0;
+#endif
+}
+
+/// pre: n no es NULL - quien llama tiene n en forma exclusiva
+///post: Quita la marca de borrado logico. Retorna 1 si la tenia (la clave vuelve a estar)
+static inline int revivirNodo(struct Node* n) {
+#if AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    return InterlockedExchange(&n->borrado, 0) != 0;
+#else
+    (void)n;
+    return 0;
+#endif
+}
+
+/// pre: arbol inicializado
+///post: Toma el arbol en forma exclusiva: nadie mas lo lee ni lo modifica hasta avlLiberarEscritura
+static inline void avlBloquearEscritura(struct ArbolAVL* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoTomar(&arbol->cerrojo);
+#elif AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    AcquireSRWLockExclusive(&arbol->lock);
+#else
+    (void)arbol;
+#endif
+}
+
+static inline void avlLiberarEscritura(struct ArbolAVL* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoSoltar(&arbol->cerrojo);
+#elif AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    ReleaseSRWLockExclusive(&arbol->lock);
+#else
+    (void)arbol;
+#endif
+}
+
+/// pre: arbol inicializado
+///post: Garantiza que el arbol no cambie mientras se recorre entero. Con la politica lector-escritor
+///      admite otros lectores; con la fina es exclusivo, porque las inserciones toman el arbol compartido
+static inline void avlBloquearLectura(struct ArbolAVL* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_LECTOR_ESCRITOR
+    AcquireSRWLockShared(&arbol->lock);
+#else
+    avlBloquearEscritura(arbol);
+#endif
+}
+
+static inline void avlLiberarLectura(struct ArbolAVL* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_LECTOR_ESCRITOR
+    ReleaseSRWLockShared(&arbol->lock);
+#else
+    avlLiberarEscritura(arbol);
+#endif
+}
+
+#endif // AVL_H
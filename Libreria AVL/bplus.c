@@ -0,0 +1,480 @@
+#include <string.h>
+#include <malloc.h>     // _aligned_malloc para que cada nodo empiece en una linea de cache
+#include "bplus.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>  // Comparacion de 4 claves por instruccion dentro del nodo
+#define BMAS_SIMD 1
+#endif
+
+#define BMAS_MINIMO_HOJA (BMAS_CLAVES_HOJA / 2)
+#define BMAS_MINIMO_INTERNO (BMAS_CLAVES_INTERNO / 2)
+#define BMAS_TRAMO_LINEAL 64    // Nodos mas grandes primero se acotan con busqueda binaria
+
+// ---------------------------------- Busqueda dentro del nodo ----------------------------------
+
+#ifdef BMAS_SIMD
+static const char bitsEnMascara[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+#endif
+
+/// pre: claves tiene cantidad enteros
+///post: Retorna cuantas claves son mayores que key. Sin saltos dependientes de los datos:
+///      con SSE2 compara de a 4 claves y suma las mascaras
+static int contarMayores(const int* claves, int cantidad, int key) {
+    int mayores = 0;
+    int i = 0;
+#ifdef BMAS_SIMD
+    __m128i k = _mm_set1_epi32(key);
+    for (; i + 4 <= cantidad; i += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(claves + i));
+        mayores += bitsEnMascara[_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(c, k)))];
+    }
+#endif
+    for (; i < cantidad; i++)
+        mayores += claves[i] > key;
+    return mayores;
+}
+
+/// pre: claves ordenadas de menor a mayor
+///post: Retorna cuantas claves son <= key: en un interno es el hijo a seguir, en una hoja la
+///      posicion donde iria key (si ya esta, es la siguiente a ella)
+static int posicionEnNodo(const int* claves, int cantidad, int key) {
+    int base = 0;
+    while (cantidad > BMAS_TRAMO_LINEAL) {
+        int mitad = cantidad / 2;
+        if (claves[base + mitad - 1] <= key) {
+            base += mitad;
+            cantidad -= mitad;
+        } else {
+            cantidad = mitad;
+        }
+    }
+    return base + cantidad - contarMayores(claves + base, cantidad, key);
+}
+
+// ---------------------------------- Nodos ----------------------------------
+
+static struct HojaBMas* crearHoja() {
+    struct HojaBMas* hoja = (struct HojaBMas*)memoriaReservarAlineado(MEMORIA_BMAS, sizeof(struct HojaBMas), BMAS_ALINEACION);
+    hoja->cab.cantidad = 0;
+    hoja->cab.esHoja = 1;
+    hoja->siguiente = NULL;
+    return hoja;
+}
+
+static struct InternoBMas* crearInterno() {
+    struct InternoBMas* interno = (struct InternoBMas*)memoriaReservarAlineado(MEMORIA_BMAS, sizeof(struct InternoBMas), BMAS_ALINEACION);
+    interno->cab.cantidad = 0;
+    interno->cab.esHoja = 0;
+    return interno;
+}
+
+/// pre: nodo viene de crearHoja o crearInterno y ya no esta enlazado
+///post: Devuelve su memoria descontandola de MEMORIA_BMAS
+static void liberarNodoBMas(struct NodoBMas* nodo) {
+    size_t bytes = nodo->esHoja ? sizeof(struct HojaBMas) : sizeof(struct InternoBMas);
+    memoriaLiberarAlineado(MEMORIA_BMAS, nodo, bytes, BMAS_ALINEACION);
+}
+
+/// pre: nodo distinto de NULL
+///post: Retorna la hoja de mas a la izquierda del subarbol
+static struct HojaBMas* hojaMinima(struct NodoBMas* nodo) {
+    while (!nodo->esHoja)
+        nodo = ((struct InternoBMas*)nodo)->hijos[0];
+    return (struct HojaBMas*)nodo;
+}
+
+// ---------------------------------- Insercion ----------------------------------
+
+/// pre: la hoja esta llena - pos: lugar de key
+///post: Reparte las claves mas key entre la hoja y una hoja nueva a su derecha, que queda enlazada.
+///      Retorna la hoja nueva y deja en separador su primera clave
+static struct HojaBMas* dividirHoja(struct HojaBMas* hoja, int pos, int key, int* separador) {
+    int todas[BMAS_CLAVES_HOJA + 1];
+    int total = hoja->cab.cantidad + 1;
+    memcpy(todas, hoja->claves, pos * sizeof(int));
+    todas[pos] = key;
+    memcpy(todas + pos + 1, hoja->claves + pos, (hoja->cab.cantidad - pos) * sizeof(int));
+
+    struct HojaBMas* derecha = crearHoja();
+    int izq = total / 2;
+    memcpy(hoja->claves, todas, izq * sizeof(int));
+    memcpy(derecha->claves, todas + izq, (total - izq) * sizeof(int));
+    hoja->cab.cantidad = izq;
+    derecha->cab.cantidad = total - izq;
+
+    derecha->siguiente = hoja->siguiente;
+    hoja->siguiente = derecha;
+    *separador = derecha->claves[0];
+    return derecha;
+}
+
+/// pre: el interno esta lleno - pos: lugar del separador nuevo, cuyo hijo derecho es nuevo
+///post: Reparte claves e hijos con un interno nuevo y sube la clave del medio en separador.
+///      Retorna el interno nuevo
+static struct InternoBMas* dividirInterno(struct InternoBMas* interno, int pos, int sep, struct NodoBMas* nuevo, int* separador) {
+    int claves[BMAS_CLAVES_INTERNO + 1];
+    struct NodoBMas* hijos[BMAS_CLAVES_INTERNO + 2];
+    int total = interno->cab.cantidad + 1;
+    memcpy(claves, interno->claves, pos * sizeof(int));
+    claves[pos] = sep;
+    memcpy(claves + pos + 1, interno->claves + pos, (interno->cab.cantidad - pos) * sizeof(int));
+    memcpy(hijos, interno->hijos, (pos + 1) * sizeof(struct NodoBMas*));
+    hijos[pos + 1] = nuevo;
+    memcpy(hijos + pos + 2, interno->hijos + pos + 1, (interno->cab.cantidad - pos) * sizeof(struct NodoBMas*));
+
+    // La clave del medio sube al padre: no queda en ninguno de los dos internos
+    struct InternoBMas* derecha = crearInterno();
+    int izq = total / 2;
+    int der = total - izq - 1;
+    memcpy(interno->claves, claves, izq * sizeof(int));
+    memcpy(interno->hijos, hijos, (izq + 1) * sizeof(struct NodoBMas*));
+    memcpy(derecha->claves, claves + izq + 1, der * sizeof(int));
+    memcpy(derecha->hijos, hijos + izq + 1, (der + 1) * sizeof(struct NodoBMas*));
+    interno->cab.cantidad = izq;
+    derecha->cab.cantidad = der;
+
+    *separador = claves[izq];
+    return derecha;
+}
+
+/// pre: nodo distinto de NULL
+///post: Inserta key en el subarbol. Si el nodo se dividio retorna su nuevo hermano derecho y deja
+///      en separador la clave que lo separa; si no retorna NULL
+static struct NodoBMas* insertarEn(struct NodoBMas* nodo, int key, int* separador, int* insertado) {
+    int pos;
+
+    if (nodo->esHoja) {
+        struct HojaBMas* hoja = (struct HojaBMas*)nodo;
+        pos = posicionEnNodo(hoja->claves, nodo->cantidad, key);
+        if (pos > 0 && hoja->claves[pos - 1] == key)
+            return NULL;    // No se admiten duplicados
+        *insertado = 1;
+        if (nodo->cantidad == BMAS_CLAVES_HOJA)
+            return (struct NodoBMas*)dividirHoja(hoja, pos, key, separador);
+        memmove(hoja->claves + pos + 1, hoja->claves + pos, (nodo->cantidad - pos) * sizeof(int));
+        hoja->claves[pos] = key;
+        nodo->cantidad++;
+        return NULL;
+    }
+
+    struct InternoBMas* interno = (struct InternoBMas*)nodo;
+    pos = posicionEnNodo(interno->claves, nodo->cantidad, key);
+    int sep;
+    struct NodoBMas* nuevo = insertarEn(interno->hijos[pos], key, &sep, insertado);
+    if (nuevo == NULL)
+        return NULL;
+
+    // El hijo se dividio: hay que agregar su hermano a este interno
+    if (nodo->cantidad == BMAS_CLAVES_INTERNO)
+        return (struct NodoBMas*)dividirInterno(interno, pos, sep, nuevo, separador);
+    memmove(interno->claves + pos + 1, interno->claves + pos, (nodo->cantidad - pos) * sizeof(int));
+    memmove(interno->hijos + pos + 2, interno->hijos + pos + 1, (nodo->cantidad - pos) * sizeof(struct NodoBMas*));
+    interno->claves[pos] = sep;
+    interno->hijos[pos + 1] = nuevo;
+    nodo->cantidad++;
+    return NULL;
+}
+
+/// pre: raiz puede ser NULL - insertado: salida
+///post: Inserta key si no estaba (insertado = 1) y retorna la raiz, que cambia si la raiz vieja se dividio
+struct NodoBMas* bmasInsert(struct NodoBMas* raiz, int key, int* insertado) {
+    *insertado = 0;
+    if (raiz == NULL) {
+        struct HojaBMas* hoja = crearHoja();
+        hoja->claves[0] = key;
+        hoja->cab.cantidad = 1;
+        *insertado = 1;
+        return (struct NodoBMas*)hoja;
+    }
+
+    int sep;
+    struct NodoBMas* nuevo = insertarEn(raiz, key, &sep, insertado);
+    if (nuevo == NULL)
+        return raiz;
+
+    // La raiz se dividio: el arbol crece un nivel por arriba, todas las hojas siguen a la misma profundidad
+    struct InternoBMas* nuevaRaiz = crearInterno();
+    nuevaRaiz->claves[0] = sep;
+    nuevaRaiz->hijos[0] = raiz;
+    nuevaRaiz->hijos[1] = nuevo;
+    nuevaRaiz->cab.cantidad = 1;
+    return (struct NodoBMas*)nuevaRaiz;
+}
+
+// ---------------------------------- Eliminacion ----------------------------------
+
+/// pre: padre->hijos[i] y padre->hijos[i + 1] juntos entran en un nodo
+///post: Pasa todo el hermano derecho al izquierdo, lo libera y lo quita del padre
+static void fusionarHijos(struct InternoBMas* padre, int i) {
+    struct NodoBMas* a = padre->hijos[i];
+    struct NodoBMas* b = padre->hijos[i + 1];
+
+    if (a->esHoja) {
+        struct HojaBMas* izq = (struct HojaBMas*)a;
+        struct HojaBMas* der = (struct HojaBMas*)b;
+        memcpy(izq->claves + a->cantidad, der->claves, b->cantidad * sizeof(int));
+        a->cantidad += b->cantidad;
+        izq->siguiente = der->siguiente;
+    } else {
+        // En los internos el separador del padre baja entre las claves de ambos
+        struct InternoBMas* izq = (struct InternoBMas*)a;
+        struct InternoBMas* der = (struct InternoBMas*)b;
+        izq->claves[a->cantidad] = padre->claves[i];
+        memcpy(izq->claves + a->cantidad + 1, der->claves, b->cantidad * sizeof(int));
+        memcpy(izq->hijos + a->cantidad + 1, der->hijos, (b->cantidad + 1) * sizeof(struct NodoBMas*));
+        a->cantidad += b->cantidad + 1;
+    }
+    liberarNodoBMas(b);
+
+    memmove(padre->claves + i, padre->claves + i + 1, (padre->cab.cantidad - i - 1) * sizeof(int));
+    memmove(padre->hijos + i + 1, padre->hijos + i + 2, (padre->cab.cantidad - i - 1) * sizeof(struct NodoBMas*));
+    padre->cab.cantidad--;
+}
+
+/// pre: padre->hijos[i] quedo con menos claves que el minimo
+///post: Le presta una clave un hermano que tenga de sobra; si ninguno tiene, lo fusiona con uno
+static void corregirHijo(struct InternoBMas* padre, int i) {
+    struct NodoBMas* hijo = padre->hijos[i];
+    struct NodoBMas* izq = (i > 0) ? padre->hijos[i - 1] : NULL;
+    struct NodoBMas* der = (i < padre->cab.cantidad) ? padre->hijos[i + 1] : NULL;
+    int minimo = hijo->esHoja ? BMAS_MINIMO_HOJA : BMAS_MINIMO_INTERNO;
+
+    if (izq != NULL && izq->cantidad > minimo) {
+        // Pasa la ultima clave del hermano izquierdo al principio del hijo
+        if (hijo->esHoja) {
+            struct HojaBMas* h = (struct HojaBMas*)hijo;
+            memmove(h->claves + 1, h->claves, hijo->cantidad * sizeof(int));
+            h->claves[0] = ((struct HojaBMas*)izq)->claves[izq->cantidad - 1];
+            padre->claves[i - 1] = h->claves[0];
+        } else {
+            struct InternoBMas* h = (struct InternoBMas*)hijo;
+            struct InternoBMas* hi = (struct InternoBMas*)izq;
+            memmove(h->claves + 1, h->claves, hijo->cantidad * sizeof(int));
+            memmove(h->hijos + 1, h->hijos, (hijo->cantidad + 1) * sizeof(struct NodoBMas*));
+            h->claves[0] = padre->claves[i - 1];
+            h->hijos[0] = hi->hijos[izq->cantidad];
+            padre->claves[i - 1] = hi->claves[izq->cantidad - 1];
+        }
+        izq->cantidad--;
+        hijo->cantidad++;
+    } else if (der != NULL && der->cantidad > minimo) {
+        // Pasa la primera clave del hermano derecho al final del hijo
+        if (hijo->esHoja) {
+            struct HojaBMas* h = (struct HojaBMas*)hijo;
+            struct HojaBMas* hd = (struct HojaBMas*)der;
+            h->claves[hijo->cantidad] = hd->claves[0];
+            memmove(hd->claves, hd->claves + 1, (der->cantidad - 1) * sizeof(int));
+            padre->claves[i] = hd->claves[0];
+        } else {
+            struct InternoBMas* h = (struct InternoBMas*)hijo;
+            struct InternoBMas* hd = (struct InternoBMas*)der;
+            h->claves[hijo->cantidad] = padre->claves[i];
+            h->hijos[hijo->cantidad + 1] = hd->hijos[0];
+            padre->claves[i] = hd->claves[0];
+            memmove(hd->claves, hd->claves + 1, (der->cantidad - 1) * sizeof(int));
+            memmove(hd->hijos, hd->hijos + 1, der->cantidad * sizeof(struct NodoBMas*));
+        }
+        der->cantidad--;
+        hijo->cantidad++;
+    } else if (izq != NULL) {
+        fusionarHijos(padre, i - 1);
+    } else {
+        fusionarHijos(padre, i);
+    }
+}
+
+/// pre: nodo distinto de NULL
+///post: Quita key del subarbol si esta (eliminado = 1) y corrige los hijos que queden por debajo del minimo.
+///      Los separadores de los internos pueden quedar con claves borradas: solo guian la bajada
+static void eliminarEn(struct NodoBMas* nodo, int key, int* eliminado) {
+    if (nodo->esHoja) {
+        struct HojaBMas* hoja = (struct HojaBMas*)nodo;
+        int pos = posicionEnNodo(hoja->claves, nodo->cantidad, key);
+        if (pos == 0 || hoja->claves[pos - 1] != key)
+            return;
+        memmove(hoja->claves + pos - 1, hoja->claves + pos, (nodo->cantidad - pos) * sizeof(int));
+        nodo->cantidad--;
+        *eliminado = 1;
+        return;
+    }
+
+    struct InternoBMas* interno = (struct InternoBMas*)nodo;
+    int i = posicionEnNodo(interno->claves, nodo->cantidad, key);
+    struct NodoBMas* hijo = interno->hijos[i];
+    eliminarEn(hijo, key, eliminado);
+    if (*eliminado && hijo->cantidad < (hijo->esHoja ? BMAS_MINIMO_HOJA : BMAS_MINIMO_INTERNO))
+        corregirHijo(interno, i);
+}
+
+/// pre: raiz puede ser NULL - eliminado: salida
+///post: Elimina key si estaba (eliminado = 1) y retorna la raiz, que baja un nivel si quedo con un solo hijo
+struct NodoBMas* bmasDelete(struct NodoBMas* raiz, int key, int* eliminado) {
+    *eliminado = 0;
+    if (raiz == NULL)
+        return NULL;
+
+    eliminarEn(raiz, key, eliminado);
+    if (raiz->cantidad > 0)
+        return raiz;
+
+    struct NodoBMas* nuevaRaiz = raiz->esHoja ? NULL : ((struct InternoBMas*)raiz)->hijos[0];
+    liberarNodoBMas(raiz);
+    return nuevaRaiz;
+}
+
+// ---------------------------------- Consultas y recorridos ----------------------------------
+
+/// pre: raiz puede ser NULL
+///post: Retorna 1 si key esta en el arbol, 0 si no. Lee un nodo por nivel
+int bmasBuscar(struct NodoBMas* raiz, int key) {
+    if (raiz == NULL)
+        return 0;
+    while (!raiz->esHoja) {
+        struct InternoBMas* interno = (struct InternoBMas*)raiz;
+        raiz = interno->hijos[posicionEnNodo(interno->claves, raiz->cantidad, key)];
+    }
+    struct HojaBMas* hoja = (struct HojaBMas*)raiz;
+    int pos = posicionEnNodo(hoja->claves, raiz->cantidad, key);
+    return pos > 0 && hoja->claves[pos - 1] == key;
+}
+
+/// pre: desde <= hasta - destino puede ser NULL
+///post: Retorna cuantas claves hay en [desde, hasta] y copia las primeras capacidad en destino.
+///      Baja una sola vez y despues avanza por las hojas enlazadas
+int bmasRango(struct NodoBMas* raiz, int desde, int hasta, int* destino, int capacidad) {
+    if (raiz == NULL)
+        return 0;
+    while (!raiz->esHoja) {
+        struct InternoBMas* interno = (struct InternoBMas*)raiz;
+        raiz = interno->hijos[posicionEnNodo(interno->claves, raiz->cantidad, desde)];
+    }
+
+    struct HojaBMas* hoja = (struct HojaBMas*)raiz;
+    int i = posicionEnNodo(hoja->claves, raiz->cantidad, desde);
+    if (i > 0 && hoja->claves[i - 1] == desde)
+        i--;
+
+    int encontradas = 0;
+    for (; hoja != NULL; hoja = hoja->siguiente, i = 0) {
+        for (; i < hoja->cab.cantidad; i++) {
+            if (hoja->claves[i] > hasta)
+                return encontradas;
+            if (destino != NULL && encontradas < capacidad)
+                destino[encontradas] = hoja->claves[i];
+            encontradas++;
+        }
+    }
+    return encontradas;
+}
+
+/// pre: raiz puede ser NULL
+///post: Retorna la cantidad de claves recorriendo las hojas enlazadas
+int bmasContarClaves(struct NodoBMas* raiz) {
+    int total = 0;
+    if (raiz == NULL)
+        return 0;
+    for (struct HojaBMas* hoja = hojaMinima(raiz); hoja != NULL; hoja = hoja->siguiente)
+        total += hoja->cab.cantidad;
+    return total;
+}
+
+/// pre: nodo puede ser NULL
+///post: Retorna la cantidad de nodos (internos y hojas) del subarbol
+int bmasContarNodos(struct NodoBMas* nodo) {
+    if (nodo == NULL)
+        return 0;
+    int total = 1;
+    if (!nodo->esHoja) {
+        struct InternoBMas* interno = (struct InternoBMas*)nodo;
+        for (int i = 0; i <= nodo->cantidad; i++)
+            total += bmasContarNodos(interno->hijos[i]);
+    }
+    return total;
+}
+
+/// pre: raiz puede ser NULL
+///post: Retorna la cantidad de niveles: todas las hojas estan a la misma profundidad
+int bmasAltura(struct NodoBMas* raiz) {
+    int altura = 0;
+    if (raiz == NULL)
+        return 0;
+    for (altura = 1; !raiz->esHoja; altura++)
+        raiz = ((struct InternoBMas*)raiz)->hijos[0];
+    return altura;
+}
+
+/// pre: raiz puede ser NULL
+///post: Imprime las claves en orden ascendente recorriendo las hojas enlazadas
+void bmasPrintInOrder(struct NodoBMas* raiz) {
+    if (raiz == NULL)
+        return;
+    for (struct HojaBMas* hoja = hojaMinima(raiz); hoja != NULL; hoja = hoja->siguiente)
+        for (int i = 0; i < hoja->cab.cantidad; i++)
+            printf("%d ", hoja->claves[i]);
+}
+
+/// pre: nodo puede ser NULL
+///post: Libera el subarbol
+void bmasLiberar(struct NodoBMas* nodo) {
+    if (nodo == NULL)
+        return;
+    if (!nodo->esHoja) {
+        struct InternoBMas* interno = (struct InternoBMas*)nodo;
+        for (int i = 0; i <= nodo->cantidad; i++)
+            bmasLiberar(interno->hijos[i]);
+    }
+    liberarNodoBMas(nodo);
+}
+
+// ---------------------------------- Arbol con politica de sincronizacion ----------------------------------
+
+/// pre: arbol sin inicializar
+///post: Deja el arbol vacio y crea su bloqueo segun AVL_SINCRONIZACION
+void bmasInicializar(struct ArbolBMas* arbol) {
+    arbol->raiz = NULL;
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoInicializar(&arbol->cerrojo);
+#elif AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    InitializeSRWLock(&arbol->lock);
+#endif
+}
+
+/// pre: Ningun hilo usa el arbol
+///post: Libera todos los nodos y el bloqueo
+void bmasDestruir(struct ArbolBMas* arbol) {
+    bmasLiberar(arbol->raiz);
+    arbol->raiz = NULL;
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoDestruir(&arbol->cerrojo);
+#endif
+}
+
+/// pre: arbol inicializado - key: dato a insertar
+///post: Inserta key con el arbol tomado en escritura. Retorna 1 si se inserto, 0 si ya estaba
+int bmasInsertar(struct ArbolBMas* arbol, int key) {
+    int insertado;
+    bmasBloquearEscritura(arbol);
+    arbol->raiz = bmasInsert(arbol->raiz, key, &insertado);
+    bmasLiberarEscritura(arbol);
+    return insertado;
+}
+
+/// pre: arbol inicializado - key: dato a eliminar
+///post: Elimina key con el arbol tomado en escritura. Retorna 1 si existia, 0 si no
+int bmasEliminar(struct ArbolBMas* arbol, int key) {
+    int eliminado;
+    bmasBloquearEscritura(arbol);
+    arbol->raiz = bmasDelete(arbol->raiz, key, &eliminado);
+    bmasLiberarEscritura(arbol);
+    return eliminado;
+}
+
+/// pre: arbol inicializado - key: dato a buscar
+///post: Retorna 1 si key esta en el arbol, 0 si no
+int bmasContiene(struct ArbolBMas* arbol, int key) {
+    bmasBloquearLectura(arbol);
+    int encontrado = bmasBuscar(arbol->raiz, key);
+    bmasLiberarLectura(arbol);
+    return encontrado;
+}
@@ -0,0 +1,112 @@
+#ifndef BPLUS_H
+#define BPLUS_H
+
+// ---------------------------------- Arbol B+ ----------------------------------
+// Segundo motor de conjunto ordenado para comparar contra el AVL con las mismas operaciones
+// (insertar, buscar, eliminar, recorrido en orden). Cada nodo ocupa BMAS_BYTES_NODO bytes alineados
+// a linea de cache: una busqueda toca unos pocos nodos en lugar de un nodo por nivel del AVL.
+// Las claves solo viven en las hojas, que estan enlazadas para recorrer rangos sin volver a bajar.
+//
+// Usa la misma politica AVL_SINCRONIZACION que el AVL, salvo la fina: el B+ no tiene bloqueo
+// por nodo y con AVL_SINC_FINA usa un SRWLOCK lector-escritor para todo el arbol.
+
+#include "avl.h"
+
+#ifndef BMAS_BYTES_NODO
+#define BMAS_BYTES_NODO 256     // 4 lineas de cache - con -DBMAS_BYTES_NODO=4096 cada nodo ocupa una pagina
+#endif
+#define BMAS_ALINEACION 64      // Linea de cache
+
+// Cantidad de claves que entran en un nodo sin pasar de BMAS_BYTES_NODO
+#define BMAS_CLAVES_HOJA ((int)((BMAS_BYTES_NODO - 2 * sizeof(int) - sizeof(void*)) / sizeof(int)))
+#define BMAS_CLAVES_INTERNO ((int)((BMAS_BYTES_NODO - 2 * sizeof(int) - sizeof(void*)) / (sizeof(int) + sizeof(void*))))
+
+// Cabecera comun: con esHoja se sabe si el nodo es una HojaBMas o un InternoBMas
+struct NodoBMas {
+    int cantidad;       // Claves en uso
+    int esHoja;
+};
+
+// Hoja: claves ordenadas y enlace a la hoja siguiente para los recorridos
+struct HojaBMas {
+    struct NodoBMas cab;
+    int claves[BMAS_CLAVES_HOJA];
+    struct HojaBMas* siguiente;
+};
+
+// Interno: el hijo i tiene las claves k con claves[i-1] <= k < claves[i]
+struct InternoBMas {
+    struct NodoBMas cab;
+    int claves[BMAS_CLAVES_INTERNO];
+    struct NodoBMas* hijos[BMAS_CLAVES_INTERNO + 1];
+};
+
+// Arbol B+ con su bloqueo segun la politica elegida
+struct ArbolBMas {
+    struct NodoBMas* raiz;      // NULL si el arbol esta vacio
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    struct CerrojoAVL cerrojo;  // El mismo cerrojo que el AVL, para comparar los motores en igualdad
+#elif AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    SRWLOCK lock;
+#endif
+};
+
+// ---------------------------------- Funciones del B+ (sin bloqueos) ----------------------------------
+struct NodoBMas* bmasInsert(struct NodoBMas* raiz, int key, int* insertado);
+struct NodoBMas* bmasDelete(struct NodoBMas* raiz, int key, int* eliminado);
+int bmasBuscar(struct NodoBMas* raiz, int key);
+int bmasRango(struct NodoBMas* raiz, int desde, int hasta, int* destino, int capacidad);
+int bmasContarClaves(struct NodoBMas* raiz);
+int bmasContarNodos(struct NodoBMas* nodo);
+int bmasAltura(struct NodoBMas* raiz);
+void bmasPrintInOrder(struct NodoBMas* raiz);
+void bmasLiberar(struct NodoBMas* nodo);
+
+// ---------------------------------- Arbol con politica de sincronizacion ----------------------------------
+void bmasInicializar(struct ArbolBMas* arbol);
+void bmasDestruir(struct ArbolBMas* arbol);
+int bmasInsertar(struct ArbolBMas* arbol, int key);
+int bmasEliminar(struct ArbolBMas* arbol, int key);
+int bmasContiene(struct ArbolBMas* arbol, int key);
+
+/// pre: arbol inicializado
+///post: Toma el arbol en forma exclusiva hasta bmasLiberarEscritura
+static inline void bmasBloquearEscritura(struct ArbolBMas* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoTomar(&arbol->cerrojo);
+#elif AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    AcquireSRWLockExclusive(&arbol->lock);
+#else
+    (void)arbol;
+#endif
+}
+
+static inline void bmasLiberarEscritura(struct ArbolBMas* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX
+    cerrojoSoltar(&arbol->cerrojo);
+#elif AVL_SINCRONIZACION != AVL_SINC_NINGUNA
+    ReleaseSRWLockExclusive(&arbol->lock);
+#else
+    (void)arbol;
+#endif
+}
+
+/// pre: arbol inicializado
+///post: Garantiza que el arbol no cambie mientras se lee. Salvo con la politica mutex admite otros lectores
+static inline void bmasBloquearLectura(struct ArbolBMas* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX || AVL_SINCRONIZACION == AVL_SINC_NINGUNA
+    bmasBloquearEscritura(arbol);
+#else
+    AcquireSRWLockShared(&arbol->lock);
+#endif
+}
+
+static inline void bmasLiberarLectura(struct ArbolBMas* arbol) {
+#if AVL_SINCRONIZACION == AVL_SINC_MUTEX || AVL_SINCRONIZACION == AVL_SINC_NINGUNA
+    bmasLiberarEscritura(arbol);
+#else
+    ReleaseSRWLockShared(&arbol->lock);
+#endif
+}
+
+#endif // BPLUS_H
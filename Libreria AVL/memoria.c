@@ -0,0 +1,173 @@
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602     // Windows 8 o posterior, como avl.h (GetProcessMemoryInfo esta en kernel32 desde Windows 7)
+#endif
+#include <windows.h>
+#include <psapi.h>      // GetProcessMemoryInfo: working set del proceso
+#include <malloc.h>     // _msize y _aligned_malloc
+#include "avl.h"        // AVL_SINCRONIZACION: con la secuencial los contadores no usan atomicos
+
+#define MEMORIA_CABECERA (2 * sizeof(void*))    // Cabecera del heap de Windows por bloque: 8 bytes en 32 bits, 16 en 64
+#define MEMORIA_LINEA_CACHE 64
+
+// Contadores de una categoria, cada una en su propia linea de cache: los motores no se invalidan entre si
+union ContadoresMemoria {
+    struct {
+        volatile LONGLONG bloques;
+        volatile LONGLONG pedidos;
+        volatile LONGLONG heap;
+        volatile LONGLONG pico;
+    } c;
+    char linea[MEMORIA_LINEA_CACHE];
+};
+
+static union ContadoresMemoria categorias[MEMORIA_CATEGORIAS];
+static size_t residenteBase;
+
+/// pre: categoria valida - pedidos y heap: bytes que se suman (positivos al reservar, negativos al liberar)
+///post: Actualiza los contadores y el pico de la categoria
+static void contar(int categoria, LONGLONG bloques, LONGLONG pedidos, LONGLONG heap) {
+    union ContadoresMemoria* m = &categorias[categoria];
+#if AVL_SINCRONIZACION == AVL_SINC_NINGUNA
+    m->c.bloques += bloques;
+    m->c.pedidos += pedidos;
+    m->c.heap += heap;
+    if (m->c.heap > m->c.pico)
+        m->c.pico = m->c.heap;
+#else
+    InterlockedExchangeAdd64(&m->c.bloques, bloques);
+    InterlockedExchangeAdd64(&m->c.pedidos, pedidos);
+    LONGLONG actual = InterlockedExchangeAdd64(&m->c.heap, heap) + heap;
+    LONGLONG pico = m->c.pico;
+    while (actual > pico) {     // Casi nunca compite: solo mientras la categoria crece
+        LONGLONG visto = InterlockedCompareExchange64(&m->c.pico, actual, pico);
+        if (visto == pico)
+            break;
+        pico = visto;
+    }
+#endif
+}
+
+/// pre: bytes y alineacion de un bloque de _aligned_malloc
+///post: Bytes que ocupa en el heap: _aligned_malloc pide alineacion - 1 de margen y un puntero al bloque real
+static LONGLONG heapAlineado(size_t bytes, size_t alineacion) {
+    return (LONGLONG)(bytes + alineacion - 1 + sizeof(void*) + MEMORIA_CABECERA);
+}
+
+/// pre: categoria: MEMORIA_AVL, MEMORIA_BMAS o MEMORIA_SKIPLIST
+///post: malloc(bytes) contado en la categoria. Retorna NULL si no hay memoria
+void* memoriaReservar(int categoria, size_t bytes) {
+    void* bloque = malloc(bytes);
+    if (bloque != NULL)
+        contar(categoria, 1, (LONGLONG)bytes, (LONGLONG)(_msize(bloque) + MEMORIA_CABECERA));
+    return bloque;
+}
+
+/// pre: bloque viene de memoriaReservar con la misma categoria y bytes, o es NULL
+///post: Lo descuenta y lo libera
+void memoriaLiberar(int categoria, void* bloque, size_t bytes) {
+    if (bloque == NULL)
+        return;
+    contar(categoria, -1, -(LONGLONG)bytes, -(LONGLONG)(_msize(bloque) + MEMORIA_CABECERA));
+    free(bloque);
+}
+
+/// pre: alineacion es potencia de 2
+///post: _aligned_malloc(bytes, alineacion) contado en la categoria. Retorna NULL si no hay memoria
+void* memoriaReservarAlineado(int categoria, size_t bytes, size_t alineacion) {
+    void* bloque = _aligned_malloc(bytes, alineacion);
+    if (bloque != NULL)
+        contar(categoria, 1, (LONGLONG)bytes, heapAlineado(bytes, alineacion));
+    return bloque;
+}
+
+/// pre: bloque viene de memoriaReservarAlineado con la misma categoria, bytes y alineacion, o es NULL
+///post: Lo descuenta y lo libera
+void memoriaLiberarAlineado(int categoria, void* bloque, size_t bytes, size_t alineacion) {
+    if (bloque == NULL)
+        return;
+    contar(categoria, -1, -(LONGLONG)bytes, -heapAlineado(bytes, alineacion));
+    _aligned_free(bloque);
+}
+
+/// pre: foto no es NULL
+///post: Copia los contadores de la categoria. Con reservas en curso cada campo es exacto pero no
+///      necesariamente del mismo instante que los otros
+void memoriaLeer(int categoria, struct MemoriaCategoria* foto) {
+    union ContadoresMemoria* m = &categorias[categoria];
+    foto->bloques = m->c.bloques;
+    foto->pedidos = m->c.pedidos;
+    foto->heap = m->c.heap;
+    foto->pico = m->c.pico;
+}
+
+/// pre:
+///post: El pico de la categoria vuelve a ser lo que ocupa ahora (para medir el pico de una carga)
+void memoriaReiniciarPico(int categoria) {
+#if AVL_SINCRONIZACION == AVL_SINC_NINGUNA
+    categorias[categoria].c.pico = categorias[categoria].c.heap;
+#else
+    InterlockedExchange64(&categorias[categoria].c.pico, categorias[categoria].c.heap);
+#endif
+}
+
+/// pre: Se llama una vez al iniciar, antes de cargar datos
+///post: Guarda el working set actual como base para la fragmentacion
+void memoriaMarcarBase(void) {
+    struct MemoriaProceso proceso;
+    if (memoriaProceso(&proceso))
+        residenteBase = proceso.residente;
+}
+
+/// pre: proceso no es NULL
+///post: Lee la memoria del proceso del sistema. Retorna 0 si no se pudo
+int memoriaProceso(struct MemoriaProceso* proceso) {
+    PROCESS_MEMORY_COUNTERS contadores;
+    proceso->base = residenteBase;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &contadores, sizeof(contadores))) {
+        proceso->residente = proceso->picoResidente = proceso->privada = 0;
+        return 0;
+    }
+    proceso->residente = contadores.WorkingSetSize;
+    proceso->picoResidente = contadores.PeakWorkingSetSize;
+    proceso->privada = contadores.PagefileUsage;
+    return 1;
+}
+
+/// pre: claves: claves que guarda la categoria (para los bytes por clave)
+///post: Escribe la tabla de memoria de la categoria y del proceso
+void memoriaMostrar(FILE* salida, int categoria, long long claves) {
+    static const char* nombres[MEMORIA_CATEGORIAS] = {"AVL", "B+", "skip list"};
+    struct MemoriaCategoria foto, otra;
+    struct MemoriaProceso proceso;
+    long long heapTotal = 0;
+
+    memoriaLeer(categoria, &foto);
+    for (int i = 0; i < MEMORIA_CATEGORIAS; i++) {     // La fragmentacion compara contra todos los nodos vivos
+        memoriaLeer(i, &otra);
+        heapTotal += otra.heap;
+    }
+    int hayProceso = memoriaProceso(&proceso);
+    size_t crecimiento = proceso.residente > proceso.base ? proceso.residente - proceso.base : 0;
+
+    fprintf(salida, "======== MEMORIA (%s) ========\n", nombres[categoria]);
+    fprintf(salida, "| %-32s | %-14s |\n", "Medida", "Valor");
+    fprintf(salida, "|----------------------------------|----------------|\n");
+    fprintf(salida, "| %-32s | %-14lld |\n", "Bloques vivos", foto.bloques);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Bytes pedidos (sizeof)", foto.pedidos);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Bytes en el heap", foto.heap);
+    fprintf(salida, "| %-32s | %-14lld |\n", "Pico en el heap", foto.pico);
+    if (claves > 0) {
+        fprintf(salida, "| %-32s | %-14.2lf |\n", "Bytes pedidos por clave", (double)foto.pedidos / claves);
+        fprintf(salida, "| %-32s | %-14.2lf |\n", "Bytes en el heap por clave", (double)foto.heap / claves);
+    }
+    if (hayProceso) {
+        fprintf(salida, "| %-32s | %-14zu |\n", "Memoria residente del proceso", proceso.residente);
+        fprintf(salida, "| %-32s | %-14zu |\n", "Pico de memoria residente", proceso.picoResidente);
+        fprintf(salida, "| %-32s | %-14zu |\n", "Memoria privada comprometida", proceso.privada);
+        fprintf(salida, "| %-32s | %-14zu |\n", "Residente desde el inicio", crecimiento);
+        if (claves > 0)
+            fprintf(salida, "| %-32s | %-14.2lf |\n", "Residente por clave", (double)crecimiento / claves);
+        if (heapTotal > 0)
+            fprintf(salida, "| %-32s | %-14.3lf |\n", "Fragmentacion (residente/heap)", (double)crecimiento / heapTotal);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+// ---------------------------------- Contabilidad de memoria ----------------------------------
+// Los nodos de los tres motores (AVL, B+ y skip list) se piden y se devuelven por aca. Por cada
+// categoria se cuentan los bloques vivos, los bytes pedidos (sizeof) y los que ocupan en el heap:
+// lo que el asignador entrego de verdad (_msize, con su redondeo y alineacion) mas la cabecera de
+// cada bloque. Tambien el pico de estos ultimos. Con las politicas concurrentes cuesta un par de
+// atomicos por reserva; con AVL_SINC_NINGUNA son sumas comunes, sin atomicos ni bloqueos.
+//
+// La memoria residente del proceso (working set) se lee del sistema. Lo que crecio desde
+// memoriaMarcarBase, comparado con los bytes vivos en el heap, da la fragmentacion: incluye lo que el
+// heap retiene despues de liberar y todo lo demas que el programa reservo (filtros, colas, pilas).
+//
+// memoria.c se compila con la misma AVL_SINCRONIZACION que avl.c. GetProcessMemoryInfo esta en kernel32 desde Windows 7
+// (K32GetProcessMemoryInfo); en versiones anteriores enlazar con -lpsapi.
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define MEMORIA_AVL 0
+#define MEMORIA_BMAS 1
+#define MEMORIA_SKIPLIST 2
+#define MEMORIA_CATEGORIAS 3
+
+// Foto de los contadores de una categoria
+struct MemoriaCategoria {
+    long long bloques;      // Bloques vivos
+    long long pedidos;      // Bytes pedidos por los bloques vivos
+    long long heap;         // Bytes que ocupan en el heap, con cabecera, redondeo y alineacion
+    long long pico;         // Maximo de heap desde el inicio o desde memoriaReiniciarPico
+};
+
+// Foto de la memoria del proceso
+struct MemoriaProceso {
+    size_t residente;       // Working set actual
+    size_t picoResidente;   // Maximo working set desde que arranco el proceso
+    size_t privada;         // Memoria privada comprometida
+    size_t base;            // Working set al llamar a memoriaMarcarBase
+};
+
+void* memoriaReservar(int categoria, size_t bytes);
+void memoriaLiberar(int categoria, void* bloque, size_t bytes);
+void* memoriaReservarAlineado(int categoria, size_t bytes, size_t alineacion);
+void memoriaLiberarAlineado(int categoria, void* bloque, size_t bytes, size_t alineacion);
+void memoriaLeer(int categoria, struct MemoriaCategoria* foto);
+void memoriaReiniciarPico(int categoria);
+void memoriaMarcarBase(void);
+int memoriaProceso(struct MemoriaProceso* proceso);
+void memoriaMostrar(FILE* salida, int categoria, long long claves);
+
+#endif // MEMORIA_H
@@ -0,0 +1,386 @@
+#include <malloc.h>     // _aligned_malloc para las ranuras de epoca
+#include <limits.h>
+#include "skiplist.h"
+#include "memoria.h"    // Los nodos se piden y devuelven contados (MEMORIA_SKIPLIST)
+
+#define SKL_UMBRAL_RETIRO 64        // Retiros de una ranura entre intentos de avanzar la epoca
+
+// ---------------------------------- Enlaces marcados ----------------------------------
+
+static int marcado(struct NodoSkl* p) {
+    return ((ULONG_PTR)p & 1) != 0;
+}
+
+static struct NodoSkl* conMarca(struct NodoSkl* p) {
+    return (struct NodoSkl*)((ULONG_PTR)p | 1);
+}
+
+static struct NodoSkl* sinMarca(struct NodoSkl* p) {
+    return (struct NodoSkl*)((ULONG_PTR)p & ~(ULONG_PTR)1);
+}
+
+/// pre: dir es un enlace de un nodo alcanzable
+///post: Si dir vale esperado lo cambia por nuevo y retorna 1; si no retorna 0
+static int cambiarEnlace(struct NodoSkl* volatile* dir, struct NodoSkl* esperado, struct NodoSkl* nuevo) {
+    return InterlockedCompareExchangePointer((PVOID volatile*)dir, nuevo, esperado) == esperado;
+}
+
+static struct NodoSkl* crearNodoSkl(int key, int niveles) {
+    struct NodoSkl* nodo = (struct NodoSkl*)memoriaReservar(MEMORIA_SKIPLIST, sizeof(struct NodoSkl) + niveles * sizeof(struct NodoSkl*));
+    nodo->key = key;
+    nodo->niveles = niveles;
+    nodo->pendientes = 2;
+    nodo->retirado = NULL;
+    for (int i = 0; i < niveles; i++)
+        nodo->siguiente[i] = NULL;
+    return nodo;
+}
+
+/// pre: nodo viene de crearNodoSkl y nadie puede estar leyendolo, o es NULL
+///post: Devuelve su memoria descontandola de MEMORIA_SKIPLIST
+static void liberarNodoSkl(struct NodoSkl* nodo) {
+    if (nodo != NULL)
+        memoriaLiberar(MEMORIA_SKIPLIST, nodo, sizeof(struct NodoSkl) + nodo->niveles * sizeof(struct NodoSkl*));
+}
+
+// ---------------------------------- Recuperacion por epocas ----------------------------------
+
+static void liberarRetirados(struct NodoSkl* nodo) {
+    while (nodo != NULL) {
+        struct NodoSkl* siguiente = nodo->retirado;
+        liberarNodoSkl(nodo);
+        nodo = siguiente;
+    }
+}
+
+/// pre:
+///post: Ocupa una ranura libre y anuncia la epoca global. Mientras la ranura este ocupada ningun
+///      nodo alcanzable desde la lista se libera. Libera lo retirado por la ranura hace 3 epocas o mas
+static struct RanuraEpoca* entrar(struct ListaSkl* lista) {
+    unsigned int i = ((unsigned int)GetCurrentThreadId() * 2654435761u) >> (32 - SKL_BITS_RANURAS);
+    while (InterlockedCompareExchange(&lista->ranuras[i].r.ocupada, 1, 0) != 0)
+        i = (i + 1) % SKL_RANURAS;
+
+    struct RanuraEpoca* r = &lista->ranuras[i].r;
+    LONG epoca = lista->epoca;
+    InterlockedExchange(&r->epoca, epoca);  // Barrera completa: el anuncio se ve antes de leer enlaces
+    if (epoca != r->ultimaEpoca) {
+        // La epoca no se repitio desde la ultima limpieza: esta lista es de la epoca - 3 o anterior
+        liberarRetirados(r->retirados[epoca % 3]);
+        r->retirados[epoca % 3] = NULL;
+        r->ultimaEpoca = epoca;
+    }
+    return r;
+}
+
+static void salir(struct RanuraEpoca* r) {
+    InterlockedExchange(&r->ocupada, 0);
+}
+
+/// pre:
+///post: Avanza la epoca global si todas las operaciones en curso ya la anunciaron
+static void intentarAvanzarEpoca(struct ListaSkl* lista) {
+    LONG epoca = lista->epoca;
+    for (int i = 0; i < SKL_RANURAS; i++) {
+        struct RanuraEpoca* r = &lista->ranuras[i].r;
+        if (r->ocupada && r->epoca != epoca)
+            return;
+    }
+    InterlockedCompareExchange(&lista->epoca, epoca + 1, epoca);
+}
+
+/// pre: r esta ocupada por quien llama - nodo ya no es alcanzable desde la cabeza
+///post: Lo encola para liberarlo cuando ningun hilo pueda tenerlo
+static void retirar(struct ListaSkl* lista, struct RanuraEpoca* r, struct NodoSkl* nodo) {
+    nodo->retirado = r->retirados[r->epoca % 3];
+    r->retirados[r->epoca % 3] = nodo;
+    if (++r->cantidadRetirados >= SKL_UMBRAL_RETIRO) {
+        r->cantidadRetirados = 0;
+        intentarAvanzarEpoca(lista);
+    }
+}
+
+/// pre: r esta ocupada por quien llama
+///post: Retorna la cantidad de niveles de un nodo nuevo: 1 con probabilidad 1/2, 2 con 1/4, ...
+static int nivelAleatorio(struct RanuraEpoca* r) {
+    unsigned int x = r->semilla;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    r->semilla = x;
+
+    int niveles = 1;
+    while (niveles < SKL_NIVEL_MAXIMO && (x & 1)) {
+        niveles++;
+        x >>= 1;
+    }
+    return niveles;
+}
+
+// ---------------------------------- Busqueda ----------------------------------
+
+/// pre: dentro de entrar/salir
+///post: Deja en preds y succs, por nivel, el ultimo nodo con clave < key y el siguiente.
+///      Desengancha en el camino los nodos marcados. Retorna 1 si succs[0] tiene key
+static int localizar(struct ListaSkl* lista, int key, struct NodoSkl** preds, struct NodoSkl** succs) {
+reintentar:
+    {
+        struct NodoSkl* pred = lista->cabeza;
+        for (int nivel = SKL_NIVEL_MAXIMO - 1; nivel >= 0; nivel--) {
+            struct NodoSkl* actual = sinMarca(pred->siguiente[nivel]);
+            while (actual != NULL) {
+                struct NodoSkl* sucesor = actual->siguiente[nivel];
+                if (marcado(sucesor)) {
+                    // actual esta borrado en este nivel: se lo saltea en pred. Si pred tambien fue
+                    // borrado su enlace esta marcado, el CAS falla y se vuelve a bajar desde la cabeza
+                    if (!cambiarEnlace(&pred->siguiente[nivel], actual, sinMarca(sucesor)))
+                        goto reintentar;
+                    actual = sinMarca(sucesor);
+                    continue;
+                }
+                if (actual->key >= key)
+                    break;
+                pred = actual;
+                actual = sucesor;
+            }
+            preds[nivel] = pred;
+            succs[nivel] = actual;
+        }
+    }
+    return succs[0] != NULL && succs[0]->key == key;
+}
+
+/// pre: dentro de entrar/salir
+///post: Retorna el primer nodo con clave >= key en el nivel 0 (puede estar marcado), sin modificar nada
+static struct NodoSkl* primeroDesde(struct ListaSkl* lista, int key) {
+    struct NodoSkl* pred = lista->cabeza;
+    struct NodoSkl* actual = NULL;
+    for (int nivel = SKL_NIVEL_MAXIMO - 1; nivel >= 0; nivel--) {
+        actual = sinMarca(pred->siguiente[nivel]);
+        while (actual != NULL) {
+            struct NodoSkl* sucesor = actual->siguiente[nivel];
+            if (marcado(sucesor)) {     // Se saltea sin desengancharlo: la busqueda solo lee
+                actual = sinMarca(sucesor);
+                continue;
+            }
+            if (actual->key >= key)
+                break;
+            pred = actual;
+            actual = sucesor;
+        }
+    }
+    return actual;
+}
+
+// ---------------------------------- Operaciones ----------------------------------
+
+/// pre: lista sin inicializar
+///post: Lista vacia con la cabeza y las ranuras de epoca
+void sklInicializar(struct ListaSkl* lista) {
+    lista->cabeza = crearNodoSkl(INT_MIN, SKL_NIVEL_MAXIMO);
+    lista->ranuras = (union RanuraAlineada*)_aligned_malloc(SKL_RANURAS * sizeof(union RanuraAlineada), SKL_LINEA_CACHE);
+    for (int i = 0; i < SKL_RANURAS; i++) {
+        struct RanuraEpoca* r = &lista->ranuras[i].r;
+        r->ocupada = 0;
+        r->epoca = 0;
+        r->ultimaEpoca = 0;
+        r->semilla = (unsigned int)(i + 1) * 2654435761u;
+        r->retirados[0] = r->retirados[1] = r->retirados[2] = NULL;
+        r->cantidadRetirados = 0;
+    }
+    lista->epoca = 0;
+}
+
+/// pre: Ningun hilo usa la lista
+///post: Libera los nodos, los retirados y las ranuras
+void sklDestruir(struct ListaSkl* lista) {
+    struct NodoSkl* nodo = lista->cabeza;
+    while (nodo != NULL) {
+        struct NodoSkl* siguiente = sinMarca(nodo->siguiente[0]);
+        liberarNodoSkl(nodo);
+        nodo = siguiente;
+    }
+    for (int i = 0; i < SKL_RANURAS; i++)
+        for (int e = 0; e < 3; e++)
+            liberarRetirados(lista->ranuras[i].r.retirados[e]);
+    _aligned_free(lista->ranuras);
+    lista->cabeza = NULL;
+}
+
+/// pre: lista inicializada - key: dato a insertar
+///post: Inserta key si no estaba. Queda en el conjunto cuando se enlaza el nivel 0; los niveles
+///      de arriba se enlazan despues y solo aceleran las busquedas. Retorna 1 si se inserto, 0 si ya estaba
+int sklInsertar(struct ListaSkl* lista, int key) {
+    struct NodoSkl* preds[SKL_NIVEL_MAXIMO];
+    struct NodoSkl* succs[SKL_NIVEL_MAXIMO];
+    struct RanuraEpoca* r = entrar(lista);
+    int niveles = nivelAleatorio(r);
+    struct NodoSkl* nodo = NULL;
+
+    while (1) {
+        if (localizar(lista, key, preds, succs)) {
+            liberarNodoSkl(nodo);     // Nunca fue visible para otro hilo
+            salir(r);
+            return 0;
+        }
+        if (nodo == NULL)
+            nodo = crearNodoSkl(key, niveles);
+        for (int i = 0; i < niveles; i++)
+            nodo->siguiente[i] = succs[i];
+        if (cambiarEnlace(&preds[0]->siguiente[0], succs[0], nodo))
+            break;
+    }
+
+    for (int nivel = 1; nivel < niveles; nivel++) {
+        while (1) {
+            struct NodoSkl* propio = nodo->siguiente[nivel];
+            if (marcado(propio))
+                goto terminar;      // Lo estan borrando: no tiene sentido seguir enlazandolo
+            if (propio != succs[nivel] && !cambiarEnlace(&nodo->siguiente[nivel], propio, succs[nivel]))
+                goto terminar;      // Solo falla si lo marcaron
+            if (cambiarEnlace(&preds[nivel]->siguiente[nivel], succs[nivel], nodo))
+                break;
+            if (!localizar(lista, key, preds, succs) || succs[0] != nodo)
+                goto terminar;      // Ya lo borraron del nivel 0
+        }
+    }
+
+terminar:
+    // Si lo borraron mientras se enlazaba, algun nivel pudo quedar enlazado despues de que el
+    // borrado lo desenganchara: se vuelve a pasar para sacarlo antes de soltarlo
+    if (marcado(nodo->siguiente[0]))
+        localizar(lista, key, preds, succs);
+    if (InterlockedDecrement(&nodo->pendientes) == 0)
+        retirar(lista, r, nodo);
+    salir(r);
+    return 1;
+}
+
+/// pre: lista inicializada - key: dato a eliminar
+///post: Marca los enlaces del nodo de arriba hacia abajo; el borrado ocurre al marcar el nivel 0.
+///      Despues lo desengancha de todos los niveles. Retorna 1 si lo borro este hilo, 0 si no estaba
+int sklEliminar(struct ListaSkl* lista, int key) {
+    struct NodoSkl* preds[SKL_NIVEL_MAXIMO];
+    struct NodoSkl* succs[SKL_NIVEL_MAXIMO];
+    struct RanuraEpoca* r = entrar(lista);
+
+    if (!localizar(lista, key, preds, succs)) {
+        salir(r);
+        return 0;
+    }
+
+    struct NodoSkl* victima = succs[0];
+    for (int nivel = victima->niveles - 1; nivel >= 1; nivel--) {
+        struct NodoSkl* sucesor = victima->siguiente[nivel];
+        while (!marcado(sucesor)) {
+            cambiarEnlace(&victima->siguiente[nivel], sucesor, conMarca(sucesor));
+            sucesor = victima->siguiente[nivel];
+        }
+    }
+
+    struct NodoSkl* sucesor = victima->siguiente[0];
+    while (1) {
+        if (marcado(sucesor)) {
+            salir(r);       // Otro hilo lo borro primero
+            return 0;
+        }
+        if (cambiarEnlace(&victima->siguiente[0], sucesor, conMarca(sucesor)))
+            break;
+        sucesor = victima->siguiente[0];
+    }
+
+    localizar(lista, key, preds, succs);    // Lo desengancha de todos los niveles
+    if (InterlockedDecrement(&victima->pendientes) == 0)
+        retirar(lista, r, victima);
+    salir(r);
+    return 1;
+}
+
+/// pre: lista inicializada - key: dato a buscar
+///post: Retorna 1 si key esta en el conjunto, 0 si no. No escribe en la lista
+int sklContiene(struct ListaSkl* lista, int key) {
+    struct RanuraEpoca* r = entrar(lista);
+    struct NodoSkl* nodo = primeroDesde(lista, key);
+    int encontrado = nodo != NULL && nodo->key == key && !marcado(nodo->siguiente[0]);
+    salir(r);
+    return encontrado;
+}
+
+/// pre: lista inicializada
+///post: Retorna 1 si no hay ninguna clave
+int sklVacia(struct ListaSkl* lista) {
+    struct RanuraEpoca* r = entrar(lista);
+    struct NodoSkl* nodo = sinMarca(lista->cabeza->siguiente[0]);
+    while (nodo != NULL && marcado(nodo->siguiente[0]))
+        nodo = sinMarca(nodo->siguiente[0]);
+    salir(r);
+    return nodo == NULL;
+}
+
+/// pre: desde <= hasta - destino puede ser NULL
+///post: Retorna cuantas claves hay en [desde, hasta] y copia las primeras capacidad en destino.
+///      Con escrituras concurrentes cada clave se ve o no segun el momento en que se paso por ella
+int sklRango(struct ListaSkl* lista, int desde, int hasta, int* destino, int capacidad) {
+    int encontradas = 0;
+    struct RanuraEpoca* r = entrar(lista);
+    for (struct NodoSkl* nodo = primeroDesde(lista, desde); nodo != NULL && nodo->key <= hasta;
+         nodo = sinMarca(nodo->siguiente[0])) {
+        if (marcado(nodo->siguiente[0]))
+            continue;
+        if (destino != NULL && encontradas < capacidad)
+            destino[encontradas] = nodo->key;
+        encontradas++;
+    }
+    salir(r);
+    return encontradas;
+}
+
+/// pre: lista inicializada - memoria y nivelMaximo pueden ser NULL
+///post: Retorna la cantidad de claves; deja en memoria los bytes de sus nodos y en nivelMaximo
+///      la torre mas alta
+int sklContar(struct ListaSkl* lista, size_t* memoria, int* nivelMaximo) {
+    int claves = 0;
+    size_t bytes = 0;
+    int maximo = 0;
+    struct RanuraEpoca* r = entrar(lista);
+    for (struct NodoSkl* nodo = sinMarca(lista->cabeza->siguiente[0]); nodo != NULL; nodo = sinMarca(nodo->siguiente[0])) {
+        if (marcado(nodo->siguiente[0]))
+            continue;
+        claves++;
+        bytes += sizeof(struct NodoSkl) + nodo->niveles * sizeof(struct NodoSkl*);
+        if (nodo->niveles > maximo)
+            maximo = nodo->niveles;
+    }
+    salir(r);
+    if (memoria != NULL)
+        *memoria = bytes;
+    if (nivelMaximo != NULL)
+        *nivelMaximo = maximo;
+    return claves;
+}
+
+/// pre: lista inicializada
+///post: Imprime las claves en orden ascendente recorriendo el nivel 0
+void sklPrintInOrder(struct ListaSkl* lista) {
+    struct RanuraEpoca* r = entrar(lista);
+    for (struct NodoSkl* nodo = sinMarca(lista->cabeza->siguiente[0]); nodo != NULL; nodo = sinMarca(nodo->siguiente[0]))
+        if (!marcado(nodo->siguiente[0]))
+            printf("%d ", nodo->key);
+    salir(r);
+}
+
+/// pre: lista inicializada
+///post: Elimina todas las claves de a una, sin bloquear a los hilos que sigan usando la lista
+void sklVaciar(struct ListaSkl* lista) {
+    while (1) {
+        struct RanuraEpoca* r = entrar(lista);
+        struct NodoSkl* primero = primeroDesde(lista, INT_MIN);
+        while (primero != NULL && marcado(primero->siguiente[0]))
+            primero = sinMarca(primero->siguiente[0]);
+        int key = primero != NULL ? primero->key : 0;
+        salir(r);
+        if (primero == NULL)
+            return;
+        sklEliminar(lista, key);
+    }
+}
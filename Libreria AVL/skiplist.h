@@ -0,0 +1,70 @@
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+// ---------------------------------- Skip list sin bloqueos ----------------------------------
+// Tercer motor de conjunto ordenado: insertar, buscar, eliminar y recorrer en orden sin tomar
+// ningun bloqueo. Las modificaciones son CAS sobre los enlaces (InterlockedCompareExchangePointer);
+// un enlace con el bit bajo en 1 indica que su nodo esta borrado en ese nivel. El balance es
+// probabilistico: cada nodo tiene niveles con probabilidad 1/2, 1/4, ...
+//
+// Los nodos desenganchados no se liberan enseguida porque otro hilo puede estar leyendolos:
+// se retiran y se liberan por epocas. Cada operacion ocupa una ranura, anuncia la epoca global
+// y la suelta al terminar; la epoca avanza solo cuando todas las ranuras ocupadas la anunciaron,
+// y lo retirado hace tres epocas ya no lo puede estar leyendo nadie.
+//
+// No depende de AVL_SINCRONIZACION: funciona igual con cualquier politica.
+
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SKL_NIVEL_MAXIMO 24         // Suficiente para 2^24 claves con busquedas O(log n)
+#define SKL_BITS_RANURAS 7
+#define SKL_RANURAS (1 << SKL_BITS_RANURAS)  // Operaciones simultaneas que pueden anunciar epoca
+#define SKL_LINEA_CACHE 64
+
+struct NodoSkl {
+    int key;
+    int niveles;                    // Cantidad de enlaces de siguiente
+    volatile LONG pendientes;       // Insercion sin terminar + borrado: el ultimo en terminar lo retira
+    struct NodoSkl* retirado;       // Enlace en la lista de retirados de una ranura
+    struct NodoSkl* volatile siguiente[];   // Enlace por nivel, con marca de borrado en el bit bajo
+};
+
+// Estado de una operacion en curso. Solo la toca quien la ocupa, salvo ocupada y epoca
+struct RanuraEpoca {
+    volatile LONG ocupada;
+    volatile LONG epoca;            // Epoca global leida al entrar
+    LONG ultimaEpoca;               // Ultima epoca en la que se libero una lista de esta ranura
+    unsigned int semilla;           // Generador de niveles
+    struct NodoSkl* retirados[3];   // Nodos retirados segun epoca % 3
+    int cantidadRetirados;          // Desde el ultimo intento de avanzar la epoca
+};
+
+// Cada ranura en su propia linea de cache para que los hilos no se invaliden entre si
+union RanuraAlineada {
+    struct RanuraEpoca r;
+    char linea[((sizeof(struct RanuraEpoca) + SKL_LINEA_CACHE - 1) / SKL_LINEA_CACHE) * SKL_LINEA_CACHE];
+};
+
+struct ListaSkl {
+    struct NodoSkl* cabeza;         // Centinela con todos los niveles, su clave no se usa
+    union RanuraAlineada* ranuras;
+    volatile LONG epoca;
+};
+
+void sklInicializar(struct ListaSkl* lista);
+void sklDestruir(struct ListaSkl* lista);
+int sklInsertar(struct ListaSkl* lista, int key);
+int sklEliminar(struct ListaSkl* lista, int key);
+int sklContiene(struct ListaSkl* lista, int key);
+int sklVacia(struct ListaSkl* lista);
+int sklRango(struct ListaSkl* lista, int desde, int hasta, int* destino, int capacidad);
+int sklContar(struct ListaSkl* lista, size_t* memoria, int* nivelMaximo);
+void sklPrintInOrder(struct ListaSkl* lista);
+void sklVaciar(struct ListaSkl* lista);
+
+#endif // SKIPLIST_H